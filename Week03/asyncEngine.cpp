@@ -0,0 +1,296 @@
+/***********************************************************************
+ * Implementation:
+ *    ASYNC ENGINE
+ * Summary:
+ *    Sessions as coroutines, resumed from one epoll loop
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cstring>          // for MEMCHR and MEMMOVE
+#include <cctype>           // for ISSPACE
+#include <cerrno>           // for ERRNO
+#include <sstream>          // for OSTRINGSTREAM
+#include <fcntl.h>          // for FCNTL
+#include <unistd.h>         // for READ and CLOSE
+#include <sys/stat.h>       // for FSTAT
+#include <sys/epoll.h>      // for EPOLL_WAIT
+#include "asyncEngine.h"    // for ASYNC_ENGINE
+using namespace std;
+
+// how much one read(2) can take
+const int READ_SIZE = 65536;
+
+// how many ready sessions one epoll_wait() can report
+const int MAX_READY = 256;
+
+/********************************************
+ * IS BLANK
+ * Nothing but white space, so not a command at all
+ *******************************************/
+static bool isBlank(const char * begin, const char * end)
+{
+   while (begin != end && isspace((unsigned char)*begin))
+      begin++;
+   return begin == end;
+}
+
+/********************************************
+ * COMMAND SOURCE : NON-DEFAULT CONSTRUCTOR
+ *******************************************/
+CommandSource :: CommandSource(int fd) :
+   fd(fd), regular(false), ended(false), skipping(false),
+   buffer(READ_SIZE), begin(0), end(0)
+{
+   struct stat status;
+   if (fstat(fd, &status) != 0)
+      throw "ERROR: Unable to read commands from that descriptor";
+   regular = S_ISREG(status.st_mode);
+   if (!regular)
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/********************************************
+ * COMMAND SOURCE :: TAKE
+ * Parse the whole lines already read. Only when there
+ * are none is the descriptor read, so a batch never
+ * waits for more than it needs. A line that runs past
+ * MAX_LINE is one INVALID command, and the rest of it
+ * is thrown away as it arrives
+ *******************************************/
+CommandSource::Result CommandSource :: take(Queue <Command> & batch, int max)
+{
+   int count = 0;
+   for (;;)
+   {
+      while (count < max)
+      {
+         const char * line = buffer.data() + begin;
+         const char * newline = (const char *)memchr(line, '\n', end - begin);
+         if (newline == NULL)
+            break;
+         begin = newline + 1 - buffer.data();
+         if (skipping)
+            skipping = false;
+         else if (!isBlank(line, newline))
+         {
+            batch.push(parseCommand(line, newline));
+            count++;
+         }
+      }
+      if (count > 0)
+         return MORE;
+
+      // the last line need not end with a newline
+      if (ended)
+      {
+         const char * line = buffer.data() + begin;
+         bool last = !skipping && !isBlank(line, buffer.data() + end);
+         if (last)
+            batch.push(parseCommand(line, buffer.data() + end));
+         begin = end;
+         return last ? MORE : END;
+      }
+
+      if (end - begin >= (size_t)MAX_LINE)
+      {
+         begin = end;
+         if (!skipping)
+         {
+            skipping = true;
+            batch.push(Command());
+            return MORE;
+         }
+      }
+
+      // move the start of the next line to the front and read after it
+      if (begin != 0)
+      {
+         memmove(buffer.data(), buffer.data() + begin, end - begin);
+         end -= begin;
+         begin = 0;
+      }
+      ssize_t got = read(fd, buffer.data() + end, buffer.size() - end);
+      if (got > 0)
+         end += got;
+      else if (got == 0)
+         ended = true;
+      else if (errno == EAGAIN || errno == EWOULDBLOCK)
+         return BLOCKED;
+      else if (errno != EINTR)
+         throw "ERROR: Unable to read the commands";
+   }
+}
+
+/********************************************
+ * ASYNC ENGINE : NON-DEFAULT CONSTRUCTOR
+ * Each session's portfolio is made inside run(), so
+ * the latency tick rate is measured now rather than
+ * with the other sessions waiting
+ *******************************************/
+AsyncEngine :: AsyncEngine(const Sink & sink) : sink(sink), running(0)
+{
+   epollFd = epoll_create1(EPOLL_CLOEXEC);
+   if (epollFd < 0)
+      throw "ERROR: Unable to create the epoll instance";
+   LatencyRecorder::nanosPerTick();
+}
+
+/********************************************
+ * ASYNC ENGINE : DESTRUCTOR
+ * Destroying a suspended coroutine destroys its
+ * portfolio and everything else it had
+ *******************************************/
+AsyncEngine :: ~AsyncEngine()
+{
+   sessions.clear();
+   close(epollFd);
+}
+
+/********************************************
+ * ASYNC ENGINE :: ADD
+ * The coroutine starts suspended, so nothing is read
+ * until run() first resumes it
+ *******************************************/
+int AsyncEngine :: add(int fd)
+{
+   int session = (int)sessions.size();
+   sessions.push_back(unique_ptr <Session> (new Session(serve(session, fd))));
+   watching.push_back(-1);
+   ready.push(session);
+   running++;
+   return session;
+}
+
+/********************************************
+ * ASYNC ENGINE :: SERVE
+ * One portfolio, a batch of commands at a time. A chunk
+ * is yielded after every batch, even an empty one, so a
+ * session reading a file lets the others have a turn
+ *******************************************/
+AsyncEngine::Session AsyncEngine :: serve(int session, int fd)
+{
+   CommandSource source(fd);
+   PortfolioHistory portfolio;
+   Queue <Command> batch(MAX_BATCH);
+   Queue <Event> events;
+   ostringstream report;
+   string chunk;
+
+   bool quit = false;
+   while (!quit)
+   {
+      if (!co_await NextBatch { *this, session, source, batch,
+                                CommandSource::MORE })
+      {
+         Command end;
+         end.type = Command::QUIT;
+         batch.push(end);
+      }
+
+      Command command;
+      while (!quit && batch.tryPop(command))
+      {
+         portfolio.apply(command, events);
+         quit = (command.type == Command::QUIT);
+      }
+      batch.clear();
+
+      report.str("");
+      Event event;
+      while (events.tryPop(event))
+         report << event;
+      chunk = report.str();
+      co_yield chunk;
+   }
+}
+
+/********************************************
+ * ASYNC ENGINE :: WAIT FOR
+ * One shot, so a session is only ever resumed once for
+ * each time it waits. The first wait adds the descriptor
+ * and later ones re-arm it. A descriptor epoll will not
+ * take is treated as always ready
+ *******************************************/
+void AsyncEngine :: waitFor(int session, int fd)
+{
+   epoll_event event;
+   event.events = EPOLLIN | EPOLLONESHOT;
+   event.data.u64 = 0;
+   event.data.u32 = (uint32_t)session;
+   int operation = (watching[session] < 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD);
+   if (epoll_ctl(epollFd, operation, fd, &event) == 0)
+      watching[session] = fd;
+   else if (errno == EPERM)
+      ready.push(session);
+   else
+      throw "ERROR: Unable to wait for the commands";
+}
+
+/********************************************
+ * ASYNC ENGINE :: POLL
+ * Only called when no session can run without input
+ *******************************************/
+void AsyncEngine :: poll()
+{
+   epoll_event events[MAX_READY];
+   int count = epoll_wait(epollFd, events, MAX_READY, -1);
+   if (count < 0 && errno != EINTR)
+      throw "ERROR: Unable to wait for the commands";
+   for (int i = 0; i < count; i++)
+      ready.push((int)events[i].data.u32);
+}
+
+/********************************************
+ * ASYNC ENGINE :: FINISH
+ *******************************************/
+void AsyncEngine :: finish(int session)
+{
+   if (watching[session] >= 0)
+      epoll_ctl(epollFd, EPOLL_CTL_DEL, watching[session], NULL);
+   watching[session] = -1;
+   sessions[session].reset();
+   running--;
+}
+
+/********************************************
+ * ASYNC ENGINE :: RUN
+ * Resume the next ready session. When it stops, it has
+ * either yielded a chunk, and goes to the back of the
+ * line, or is waiting in epoll, or is done. A session
+ * that threw is finished before the exception goes on,
+ * so run() can be called again for the rest
+ *******************************************/
+void AsyncEngine :: run()
+{
+   while (running > 0)
+   {
+      int session;
+      if (!ready.tryPop(session))
+      {
+         poll();
+         continue;
+      }
+
+      coroutine_handle <Session::promise_type> handle =
+         sessions[session]->handle;
+      handle.resume();
+      Session::promise_type & promise = handle.promise();
+
+      if (promise.error)
+      {
+         exception_ptr error = promise.error;
+         finish(session);
+         rethrow_exception(error);
+      }
+      if (handle.done())
+         finish(session);
+      else if (promise.chunk != NULL)
+      {
+         if (!promise.chunk->empty())
+            sink(session, *promise.chunk);
+         promise.chunk = NULL;
+         ready.push(session);
+      }
+   }
+}
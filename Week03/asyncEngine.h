@@ -0,0 +1,209 @@
+/***********************************************************************
+ * Header:
+ *    ASYNC ENGINE
+ * Summary:
+ *    The stock program as coroutines, so one thread can keep many
+ *    portfolios going at once. Each session is a C++20 coroutine with
+ *    a portfolio of its own. It co_awaits a batch of commands from its
+ *    input, applies them, and co_yields the report they made. The
+ *    engine resumes whichever sessions can make progress and hands
+ *    each report chunk to a sink as it is yielded.
+ *
+ *    A session whose input is a pipe, a socket, or a terminal waits
+ *    for it in epoll, and is not resumed until there is something to
+ *    read. A regular file is always ready, so its session never waits;
+ *    it gives the others a turn after every batch instead. A session
+ *    ends at "quit" or at the end of its input, which is taken as a
+ *    "quit", as stocksBuySell() takes it.
+ *
+ *    Needs -std=c++20. Only the engine and its test are built that way.
+ *
+ *    This will contain the class definitions of:
+ *        CommandSource    : lines of commands read as they arrive
+ *        AsyncEngine      : many sessions on one thread
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef ASYNC_ENGINE_H
+#define ASYNC_ENGINE_H
+
+#include <coroutine>     // for COROUTINE_HANDLE
+#include <exception>     // for EXCEPTION_PTR
+#include <functional>    // for FUNCTION
+#include <memory>        // for UNIQUE_PTR
+#include <string>        // for STRING
+#include <vector>        // for VECTOR
+#include "queue.h"       // for QUEUE
+#include "stock.h"       // for COMMAND and PORTFOLIO_HISTORY
+
+/******************************************
+ * COMMAND SOURCE
+ * Reads a file descriptor a buffer at a time and parses
+ * the whole lines in it. The descriptor stays the
+ * caller's; anything but a regular file is made
+ * non-blocking
+ ******************************************/
+class CommandSource
+{
+public:
+   // what take() found
+   enum Result
+   {
+      MORE,          // some commands, or a read that may have more
+      BLOCKED,       // nothing to read until the descriptor is ready
+      END            // the input has ended and every command was taken
+   };
+
+   // a line longer than this is not a command
+   static constexpr int MAX_LINE = 4096;
+
+   // non-default constructor : read from "fd"
+   CommandSource(int fd);
+
+   // the descriptor, and whether it is worth waiting for in epoll
+   int getFd() const           { return fd;                       }
+   bool canWait() const        { return !regular;                 }
+
+   // add up to "max" commands to "batch", reading only when there is
+   // no whole line left. Blank lines are skipped. Throws if the read
+   // fails for any reason but there being nothing to read yet
+   Result take(Queue <Command> & batch, int max);
+
+private:
+   int fd;
+   bool regular;              // a regular file never blocks
+   bool ended;                // read() has returned 0
+   bool skipping;             // in a line that was too long
+   std::vector <char> buffer; // what has been read
+   size_t begin;              // the first byte not parsed yet
+   size_t end;                // one past the last byte read
+};
+
+/******************************************
+ * ASYNC ENGINE
+ * Sessions run until each one has quit. Every report
+ * chunk goes to the sink along with the number add()
+ * gave its session
+ ******************************************/
+class AsyncEngine
+{
+public:
+   typedef std::function <void (int session, const std::string & chunk)>
+      Sink;
+
+   // the most commands a session applies before the others get a turn
+   static constexpr int MAX_BATCH = 256;
+
+   // non-default constructor : where the reports go
+   AsyncEngine(const Sink & sink);
+
+   // destructor : end any sessions that are still running
+   ~AsyncEngine();
+
+   // start a session reading commands from "fd". Returns its number,
+   // counting from 0. It does not run until run() is called
+   int add(int fd);
+
+   // resume sessions until every one has quit. Rethrows anything a
+   // session throws
+   void run();
+
+   // how many sessions have not quit yet
+   int getRunning() const      { return running;                  }
+
+private:
+   /******************************************
+    * SESSION
+    * The coroutine that runs one portfolio. It yields a
+    * pointer to each report chunk it makes
+    ******************************************/
+   struct Session
+   {
+      struct promise_type
+      {
+         promise_type() : chunk(NULL) {}
+
+         Session get_return_object()
+         {
+            return Session(std::coroutine_handle <promise_type> ::
+                           from_promise(*this));
+         }
+         std::suspend_always initial_suspend() noexcept { return {};   }
+         std::suspend_always final_suspend() noexcept   { return {};   }
+         std::suspend_always yield_value(const std::string & chunk)
+         {
+            this->chunk = &chunk;
+            return {};
+         }
+         void return_void()         {                                  }
+         void unhandled_exception() { error = std::current_exception(); }
+
+         const std::string * chunk;  // yielded and not sent yet
+         std::exception_ptr error;   // what the session threw
+      };
+
+      Session(std::coroutine_handle <promise_type> handle) :
+         handle(handle) {}
+      Session(Session && rhs) : handle(rhs.handle) { rhs.handle = {};   }
+      ~Session()                     { if (handle) handle.destroy();  }
+
+      std::coroutine_handle <promise_type> handle;
+   };
+
+   /******************************************
+    * NEXT BATCH
+    * What a session co_awaits for its commands. It only
+    * suspends if there is nothing to read, and is false
+    * once the input has ended
+    ******************************************/
+   struct NextBatch
+   {
+      AsyncEngine & engine;
+      int session;
+      CommandSource & source;
+      Queue <Command> & batch;
+      CommandSource::Result result;
+
+      bool await_ready()
+      {
+         result = source.take(batch, MAX_BATCH);
+         return result != CommandSource::BLOCKED;
+      }
+      void await_suspend(std::coroutine_handle <>)
+      {
+         engine.waitFor(session, source.getFd());
+      }
+      bool await_resume()
+      {
+         if (result == CommandSource::BLOCKED)
+            result = source.take(batch, MAX_BATCH);
+         return result != CommandSource::END;
+      }
+   };
+
+   // no copying the sessions or the epoll descriptor
+   AsyncEngine(const AsyncEngine & rhs);
+   AsyncEngine & operator = (const AsyncEngine & rhs);
+
+   // the coroutine that runs session "session" on "fd"
+   Session serve(int session, int fd);
+
+   // resume "session" once "fd" can be read
+   void waitFor(int session, int fd);
+
+   // wait in epoll until at least one session is ready
+   void poll();
+
+   // a session is done: stop watching its descriptor and free it
+   void finish(int session);
+
+   Sink sink;
+   int epollFd;
+   std::vector <std::unique_ptr <Session> > sessions;  // NULL once done
+   std::vector <int> watching;  // the fd epoll knows for each, or -1
+   Queue <int> ready;           // sessions to resume, in order
+   int running;                 // sessions not done yet
+};
+
+#endif // ASYNC_ENGINE_H
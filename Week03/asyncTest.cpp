@@ -0,0 +1,401 @@
+/***********************************************************************
+* Program:
+*    ASYNC TEST
+* Summary:
+*    A non-interactive test for the coroutine engine. Random scripts of
+*    commands are run as sessions, from files and from pipes that are
+*    written a few bytes at a time by another thread, all in one engine
+*    on one thread. What each session reports must be what the same
+*    script gives when its lines are applied to a PortfolioHistory one
+*    after another. The latency lines are timings, so they are left out
+*    of the comparison.
+*
+*    This is built with -std=c++20, so it is kept apart from queueTest.
+*
+*    Run with no arguments for a fixed set of seeds, or
+*        asyncTest <seed> <operations>
+*    to reproduce a failure.
+* Author
+*    <your names here>
+************************************************************************/
+
+#include <iostream>          // for COUT
+#include <sstream>           // for OSTRINGSTREAM
+#include <string>            // for STRING
+#include <vector>            // for VECTOR
+#include <random>            // for MT19937
+#include <thread>            // for THREAD
+#include <cstdlib>           // for ATOI
+#include <csignal>           // for SIGNAL
+#include <unistd.h>          // for PIPE, WRITE, and CLOSE
+#include <fcntl.h>           // for FCNTL
+#include <cerrno>            // for ERRNO
+#include "asyncEngine.h"     // for ASYNC_ENGINE
+using namespace std;
+
+/*******************************************
+ * FAILURE
+ * Thrown when a session and the script disagree
+ *******************************************/
+struct Failure
+{
+   Failure(const char * what, long step) : what(what), step(step) {}
+   const char * what;
+   long step;
+};
+
+/*******************************************
+ * CHECK
+ * Stop the run if a condition does not hold
+ *******************************************/
+#define CHECK(condition, step)                          \
+   do                                                   \
+   {                                                    \
+      if (!(condition))                                 \
+         throw Failure(#condition, step);               \
+   }                                                    \
+   while (false)
+
+/*******************************************
+ * THROWS
+ * Did running it throw an error message?
+ *******************************************/
+template <class Function>
+bool throws(Function function)
+{
+   try
+   {
+      function();
+   }
+   catch (const char *)
+   {
+      return true;
+   }
+   return false;
+}
+
+/*******************************************
+ * RANDOM SCRIPT
+ * Commands good and bad, with blank lines, carriage
+ * returns, a line too long to be a command, and maybe
+ * a quit part way through or no newline at the end
+ *******************************************/
+string randomScript(mt19937 & random, int commands)
+{
+   const char * words[] = { "buy", "sell", "display", "lots", "asof",
+                            "stats", "bogus" };
+   string script;
+   for (int i = 0; i < commands; i++)
+   {
+      int word = (int)(random() % 10);
+      if (word > 6)
+         word = (int)(random() % 2);
+      script += words[word];
+      if (word < 2)
+         script += ' ' + to_string(random() % 300) + " $" +
+                   to_string(random() % 5 + 1) + '.' +
+                   to_string(random() % 90 + 10);
+      else if (word == 4)
+         script += ' ' + to_string(random() % (i + 2));
+
+      switch (random() % 20)
+      {
+         case 0:
+            script += "\n\n";
+            break;
+         case 1:
+            script += "\r\n";
+            break;
+         case 2:
+            script += '\n' + string(5000 + random() % 5000, 'x') + '\n';
+            break;
+         default:
+            script += '\n';
+      }
+   }
+
+   if (random() % 4 == 0)
+      script.insert(random() % (script.size() + 1), "\nquit\n");
+   if (random() % 4 == 0)
+      script.pop_back();
+   return script;
+}
+
+/*******************************************
+ * WITHOUT LATENCY
+ * The report with the latency report taken out
+ *******************************************/
+string withoutLatency(const string & report)
+{
+   istringstream in(report);
+   string kept;
+   string line;
+   while (getline(in, line))
+      if (line != "Latency by command:" &&
+          line.find(" commands, p50 ") == string::npos)
+         kept += line + '\n';
+   return kept;
+}
+
+/*******************************************
+ * EXPECTED REPORT
+ * The script a line at a time, as the engine should
+ * read it: blank lines skipped, and the end taken as
+ * a quit if it did not quit already
+ *******************************************/
+string expectedReport(const string & script)
+{
+   PortfolioHistory portfolio;
+   Queue <Event> events;
+   ostringstream report;
+   size_t begin = 0;
+   bool quit = false;
+   while (!quit)
+   {
+      Command command;
+      command.type = Command::QUIT;
+      if (begin < script.size())
+      {
+         size_t newline = script.find('\n', begin);
+         if (newline == string::npos)
+            newline = script.size();
+         string line = script.substr(begin, newline - begin);
+         begin = newline + 1;
+         if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+         command = parseCommand(line);
+      }
+      portfolio.apply(command, events);
+      quit = (command.type == Command::QUIT);
+   }
+
+   Event event;
+   while (events.tryPop(event))
+      report << event;
+   return withoutLatency(report.str());
+}
+
+/*******************************************
+ * TEMPORARY FILE
+ * A file holding the text, opened for reading and
+ * already unlinked so it goes away when it is closed
+ *******************************************/
+int temporaryFile(const string & text)
+{
+   char path[] = "/tmp/asyncTestXXXXXX";
+   int fd = mkstemp(path);
+   if (fd < 0)
+      throw "ERROR: Unable to make a temporary file";
+   unlink(path);
+   if (write(fd, text.data(), text.size()) != (ssize_t)text.size())
+      throw "ERROR: Unable to write a temporary file";
+   lseek(fd, 0, SEEK_SET);
+   return fd;
+}
+
+/*******************************************
+ * TEST FILES
+ * Sessions reading regular files, which never wait,
+ * take turns a batch at a time
+ *******************************************/
+void testFiles(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   int count = 20;
+   vector <string> scripts;
+   vector <string> reports(count);
+   AsyncEngine engine([&](int session, const string & chunk)
+   {
+      reports[session] += chunk;
+   });
+
+   vector <int> fds;
+   for (int i = 0; i < count; i++)
+   {
+      scripts.push_back(randomScript(random, (int)(operations / count)));
+      fds.push_back(temporaryFile(scripts.back()));
+      CHECK(engine.add(fds.back()) == i, i);
+   }
+   CHECK(engine.getRunning() == count, 0);
+   engine.run();
+   CHECK(engine.getRunning() == 0, 0);
+
+   for (int i = 0; i < count; i++)
+   {
+      CHECK(withoutLatency(reports[i]) == expectedReport(scripts[i]), i);
+      close(fds[i]);
+   }
+}
+
+/*******************************************
+ * TEST PIPES
+ * Many sessions reading pipes that another thread
+ * fills a few bytes at a time, in no particular order,
+ * so lines arrive split and sessions wait in epoll
+ *******************************************/
+void testPipes(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   int count = 200;
+   vector <string> scripts;
+   vector <string> reports(count);
+   vector <int> readers;
+   vector <int> writers;
+   AsyncEngine engine([&](int session, const string & chunk)
+   {
+      reports[session] += chunk;
+   });
+
+   for (int i = 0; i < count; i++)
+   {
+      int ends[2];
+      if (pipe(ends) != 0)
+         throw "ERROR: Unable to make a pipe";
+      scripts.push_back(randomScript(random, (int)(operations / count)));
+      fcntl(ends[1], F_SETFL, O_NONBLOCK);
+      readers.push_back(ends[0]);
+      writers.push_back(ends[1]);
+      engine.add(ends[0]);
+   }
+
+   // a session that quits stops reading, so its pipe may fill. The
+   // writes do not block, so the writer goes on to the other pipes,
+   // and gives up on that one once the readers are closed below
+   thread writer([&]()
+   {
+      mt19937 pieces(seed);
+      vector <size_t> written(count, 0);
+      for (int left = count; left > 0; )
+      {
+         int i = (int)(pieces() % count);
+         if (written[i] == scripts[i].size())
+            continue;
+         size_t size = min(scripts[i].size() - written[i],
+                           (size_t)(pieces() % 64 + 1));
+         if (write(writers[i], scripts[i].data() + written[i], size) < 0)
+         {
+            if (errno == EAGAIN)
+            {
+               this_thread::yield();
+               continue;
+            }
+            size = scripts[i].size() - written[i];
+         }
+         written[i] += size;
+         if (written[i] == scripts[i].size())
+         {
+            close(writers[i]);
+            left--;
+         }
+         if (pieces() % 16 == 0)
+            this_thread::yield();
+      }
+   });
+   engine.run();
+   for (int i = 0; i < count; i++)
+      close(readers[i]);
+   writer.join();
+
+   for (int i = 0; i < count; i++)
+      CHECK(withoutLatency(reports[i]) == expectedReport(scripts[i]), i);
+}
+
+/*******************************************
+ * TEST ERRORS
+ * A session that cannot read is finished and its error
+ * thrown out of run(); the others carry on when run()
+ * is called again
+ *******************************************/
+void testErrors(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   string script = randomScript(random, (int)(operations / 100) + 1);
+   string report;
+   AsyncEngine engine([&](int session, const string & chunk)
+   {
+      CHECK(session == 1, session);
+      report += chunk;
+   });
+
+   int fd = temporaryFile(script);
+   int closed = temporaryFile("buy 10 $1.00\n");
+   close(closed);
+   engine.add(closed);
+   engine.add(fd);
+   CHECK(throws([&]() { engine.run(); }), 0);
+   CHECK(engine.getRunning() == 1, 1);
+   engine.run();
+   CHECK(engine.getRunning() == 0, 2);
+   CHECK(withoutLatency(report) == expectedReport(script), 3);
+   close(fd);
+
+   // an engine can be thrown away with sessions still waiting
+   int ends[2];
+   if (pipe(ends) != 0)
+      throw "ERROR: Unable to make a pipe";
+   {
+      AsyncEngine waiting([](int, const string &) {});
+      waiting.add(ends[0]);
+   }
+   close(ends[0]);
+   close(ends[1]);
+}
+
+/*******************************************
+ * RUN
+ * Run one test, reporting how to reproduce a failure
+ *******************************************/
+bool run(const char * name, void (*test)(unsigned int, long),
+         unsigned int seed, long operations)
+{
+   try
+   {
+      test(seed, operations);
+   }
+   catch (const Failure & failure)
+   {
+      cout << "FAILED " << name << ": " << failure.what
+           << " at step " << failure.step
+           << " (asyncTest " << seed << ' ' << operations << ")\n";
+      return false;
+   }
+   catch (const char * error)
+   {
+      cout << "FAILED " << name << ": unexpected \"" << error << "\""
+           << " (asyncTest " << seed << ' ' << operations << ")\n";
+      return false;
+   }
+   return true;
+}
+
+/**********************************************************************
+ * MAIN
+ * Every test against every seed
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   unsigned int firstSeed = 1;
+   unsigned int numSeeds  = 5;
+   long operations        = 10000;
+   if (argc > 1)
+   {
+      firstSeed = atoi(argv[1]);
+      numSeeds  = 1;
+   }
+   if (argc > 2)
+      operations = atol(argv[2]);
+
+   // a pipe whose session has quit is closed under the writer
+   signal(SIGPIPE, SIG_IGN);
+
+   int failures = 0;
+   for (unsigned int seed = firstSeed; seed < firstSeed + numSeeds; seed++)
+   {
+      failures += !run("files",  testFiles,  seed, operations);
+      failures += !run("pipes",  testPipes,  seed, operations);
+      failures += !run("errors", testErrors, seed, operations);
+   }
+
+   cout << (failures ? "Async tests failed\n" : "Async tests passed\n");
+   return failures ? 1 : 0;
+}
@@ -0,0 +1,249 @@
+/***********************************************************************
+* Header:
+*    COW QUEUE
+* Summary:
+*    A Queue whose copies share their storage until one of them is
+*    changed. The items live in fixed size segments held by reference
+*    counted pointers, and the list of segments is itself shared:
+*        - copying a CowQueue is one reference count, whatever its size
+*        - changing a CowQueue that is shared first copies the list of
+*          segments, then only the segment that is written to
+*    so a copy is a consistent snapshot the moment it is made, and the
+*    queue it came from pays for it one segment at a time.
+*
+*    Copies may be handed to other threads. Each copy must only be
+*    used by one thread at a time, but a thread may read its copy while
+*    another thread changes the queue it was copied from.
+*
+*    This will contain the class definition of:
+*        CowQueue         : a copy-on-write Queue of T
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef COW_QUEUE_H
+#define COW_QUEUE_H
+
+#include <cassert>     // for ASSERT
+#include <memory>      // for SHARED_PTR
+#include <deque>       // for DEQUE
+#include <atomic>      // for ATOMIC_THREAD_FENCE
+
+/************************************************
+ * COW QUEUE
+ * A Queue of T that shares its storage with its copies
+ ***********************************************/
+template <class T>
+class CowQueue
+{
+public:
+   // how many items are in a segment, the unit that gets copied
+   enum { SEGMENT = 256 };
+
+   // default constructor : empty
+   CowQueue() : state(std::make_shared <State> ()) {}
+
+   // copies share everything, so the compiler's versions are O(1)
+
+   // how many items are in the queue
+   bool empty() const noexcept { return state->count == 0;  }
+   int size() const noexcept   { return state->count;       }
+
+   // read the items. Reading never copies anything
+   const T & front() const;
+   const T & back() const;
+   const T & operator [] (int index) const
+   {
+      assert(index >= 0 && index < size());
+      return at(*state, index);
+   }
+
+   // change the items in place. These copy what is shared first
+   T & front();
+   T & back();
+
+   // add an item to the back, remove one from either end
+   void push(const T & t);
+   void pop();
+   void popBack();
+
+   // remove everything, letting go of anything shared
+   void clear()                { state = std::make_shared <State> (); }
+
+   // does a copy still share this queue's storage?
+   bool shared() const         { return state.use_count() > 1;       }
+
+private:
+   /******************************************
+    * SEGMENT
+    * A run of items that are copied together
+    ******************************************/
+   struct Segment
+   {
+      T items[SEGMENT];
+   };
+
+   /******************************************
+    * STATE
+    * The segments in order and where the items are
+    * in them. The front item is items[head] of the
+    * first segment
+    ******************************************/
+   struct State
+   {
+      State() : head(0), count(0) {}
+      std::deque <std::shared_ptr <Segment> > segments;
+      int head;      // where the front item is in the first segment
+      int count;     // how many items there are
+   };
+
+   // the item "index" places from the front
+   static T & at(const State & s, int index)
+   {
+      int i = s.head + index;
+      return s.segments[i / SEGMENT]->items[i % SEGMENT];
+   }
+
+   // is this the only reference? The fence pairs with the release
+   // when another thread lets go of its reference, so whatever it was
+   // reading is done with before we write over it
+   template <class U>
+   static bool unique(const std::shared_ptr <U> & p)
+   {
+      if (p.use_count() != 1)
+         return false;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return true;
+   }
+
+   // a state and an item we are allowed to change
+   State & ownState();
+   T & ownItem(int index);
+
+   std::shared_ptr <State> state;
+};
+
+/**************************************
+ * COW QUEUE :: OWN STATE
+ * Copy the list of segments if another queue shares it.
+ * The segments themselves stay shared
+ ***************************************/
+template <class T>
+typename CowQueue <T> ::State & CowQueue <T> :: ownState()
+{
+   if (!unique(state))
+      state = std::make_shared <State> (*state);
+   return *state;
+}
+
+/**************************************
+ * COW QUEUE :: OWN ITEM
+ * Copy the one segment holding the item if another
+ * queue shares it
+ ***************************************/
+template <class T>
+T & CowQueue <T> :: ownItem(int index)
+{
+   State & s = ownState();
+   std::shared_ptr <Segment> & segment =
+      s.segments[(s.head + index) / SEGMENT];
+   if (!unique(segment))
+      segment = std::make_shared <Segment> (*segment);
+   return at(s, index);
+}
+
+/**************************************
+ * COW QUEUE :: FRONT and BACK
+ ***************************************/
+template <class T>
+const T & CowQueue <T> :: front() const
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   return at(*state, 0);
+}
+
+template <class T>
+const T & CowQueue <T> :: back() const
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   return at(*state, size() - 1);
+}
+
+template <class T>
+T & CowQueue <T> :: front()
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   return ownItem(0);
+}
+
+template <class T>
+T & CowQueue <T> :: back()
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   return ownItem(size() - 1);
+}
+
+/**************************************
+ * COW QUEUE :: PUSH
+ * Start a new segment when the last one is full
+ ***************************************/
+template <class T>
+void CowQueue <T> :: push(const T & t)
+{
+   State & s = ownState();
+   if (s.head + s.count == (int)s.segments.size() * SEGMENT)
+      s.segments.push_back(std::make_shared <Segment> ());
+   ownItem(s.count) = t;
+   s.count++;
+}
+
+/**************************************
+ * COW QUEUE :: POP
+ * Let go of the first segment once it is used up
+ ***************************************/
+template <class T>
+void CowQueue <T> :: pop()
+{
+   if (empty())
+      throw "ERROR: attempting to pop from an empty queue";
+   State & s = ownState();
+   s.head++;
+   s.count--;
+   if (s.count == 0)
+   {
+      s.segments.clear();
+      s.head = 0;
+   }
+   else if (s.head == SEGMENT)
+   {
+      s.segments.pop_front();
+      s.head = 0;
+   }
+}
+
+/**************************************
+ * COW QUEUE :: POP BACK
+ * Let go of the last segment once it is empty
+ ***************************************/
+template <class T>
+void CowQueue <T> :: popBack()
+{
+   if (empty())
+      throw "ERROR: attempting to pop from an empty queue";
+   State & s = ownState();
+   s.count--;
+   if (s.count == 0)
+   {
+      s.segments.clear();
+      s.head = 0;
+   }
+   else if ((s.head + s.count) % SEGMENT == 0)
+      s.segments.pop_back();
+}
+
+#endif // COW_QUEUE_H
@@ -9,29 +9,43 @@
 
 #include <iostream>  // for OSTREAM and ISTREAM
 #include <cassert>   // for ASSERT
+#include <climits>   // for INT_MAX
+#include <cstdio>    // for EOF
 #include "dollars.h" // for the class definition
 using namespace std;
 
 /********************************************
- * DOLLARS READ
- * This function reads dollars from the input stream:
+ * TEXT SOURCE
+ * peek() and get() over a range of characters, so the
+ * reader below works the same on text as on a stream
+ *******************************************/
+struct TextSource
+{
+   TextSource(const char * begin, const char * end) : p(begin), end(end) {}
+   int peek() const { return p != end ? (unsigned char)*p : EOF;   }
+   int get()        { return p != end ? (unsigned char)*p++ : EOF; }
+
+   const char * p;
+   const char * end;
+};
+
+/********************************************
+ * READ CENTS
+ * This function reads dollars from a stream or from text:
  *     - skips leading white spaces
  *     - skips leading $ signs
  *     - only consumes two decimal places
  *     - negative values work with () or -
+ *     - amounts too large for an int stop at the largest one
  * For example:
  *   $1.34     -->  134 cents
  *   -1.2      --> -120 cents
  *  $(4.211)   --> -421 cents
  *   -6        --> -600 cents
  *******************************************/
-istream & operator >> (istream & in, Dollars & rhs)
+template <class Source>
+static int readCents(Source & in)
 {
-   // initially zero
-   rhs.cents = 0;
-   if (in.fail())
-      return in;
-
    // skip leading spaces and dollar signs;
    while (isspace(in.peek()) || in.peek() == '$')
       in.get();
@@ -44,12 +58,18 @@ istream & operator >> (istream & in, Dollars & rhs)
       in.get();
    }
 
-   // consume digits, assuming they are dollars
+   // consume digits, assuming they are dollars. Work in a long long
+   // so a long string of digits cannot overflow
+   long long cents = 0;
    while (isdigit(in.peek()))
-      rhs.cents = rhs.cents * 10 + (in.get() - '0');
+   {
+      cents = cents * 10 + (in.get() - '0');
+      if (cents > INT_MAX)
+         cents = INT_MAX;
+   }
 
    // everything up to here was dollars so multiply by 100
-   rhs.cents *= 100;
+   cents *= 100;
 
    // did we get a decimal
    if ('.' == in.peek())
@@ -59,22 +79,50 @@ istream & operator >> (istream & in, Dollars & rhs)
 
       // next digit is in the 10cent place if it exists
       if (isdigit(in.peek()))
-         rhs.cents += (in.get() - '0') * 10;
+         cents += (in.get() - '0') * 10;
       // the final digit is the 1cent place if it exists
       if (isdigit(in.peek()))
-         rhs.cents += (in.get() - '0');
+         cents += (in.get() - '0');
    }
 
    // take care of the negative stuff
-   rhs.cents *= (negative ? -1 : 1);
+   if (cents > INT_MAX)
+      cents = INT_MAX;
 
    // see if there is a trailing )
    if (')' == in.peek())
       in.get();
 
+   return (int)cents * (negative ? -1 : 1);
+}
+
+/********************************************
+ * DOLLARS READ
+ * Read dollars from the input stream
+ *******************************************/
+istream & operator >> (istream & in, Dollars & rhs)
+{
+   // initially zero
+   rhs.cents = 0;
+   if (in.fail())
+      return in;
+
+   rhs.cents = readCents(in);
    return in;
 }
 
+/********************************************
+ * DOLLARS PARSE
+ * Read dollars from text, returning where we stopped
+ *******************************************/
+const char * Dollars :: parse(const char * begin, const char * end,
+                              Dollars & rhs)
+{
+   TextSource in(begin, end);
+   rhs.cents = readCents(in);
+   return in.p;
+}
+
 /*******************************************
  * DOLLARS DISPLAY
  * This function displays dollars on the screen
@@ -90,7 +138,7 @@ ostream & operator << (ostream & out, const Dollars & rhs)
 {
    // units
    out << '$';
-   int cents = rhs.cents;
+   long long cents = rhs.cents;
 
    // negative?
    if (rhs.cents < 0)
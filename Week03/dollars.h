@@ -26,7 +26,9 @@ class Dollars
   Dollars()                        : cents(0)     {                        }
   Dollars(int cents)               : cents(cents) {                        }
   Dollars(double dollars)          : cents(0)     { *this = dollars;       }
-  Dollars(const Dollars & dollars) : cents(0)     { *this = dollars;       }
+
+   // copying is left to the compiler so Dollars stays trivially
+   // copyable and can be moved around as raw bytes
 
    // operators
    Dollars & operator = (double dollars)
@@ -39,11 +41,6 @@ class Dollars
       *this = (double)dollars;
       return *this;
    }
-   Dollars & operator = (const Dollars & dollars)
-   {
-      cents = dollars.cents;
-      return *this;
-   }
    Dollars operator - (const Dollars & rhs) const
    {
       return Dollars(cents - rhs.cents);
@@ -89,6 +86,13 @@ class Dollars
       return !(*this > rhs);
    }      
 
+   // the raw number of cents, for code that stores them in bulk
+   int getCents() const { return cents; }
+
+   // read from text rather than a stream, returning where it stopped
+   static const char * parse(const char * begin, const char * end,
+                             Dollars & rhs);
+
    // input and output
    friend std::ostream & operator << (std::ostream & out, const Dollars & rhs);
    friend std::istream & operator >> (std::istream & in,        Dollars & rhs);
@@ -0,0 +1,77 @@
+/***********************************************************************
+ * Program:
+ *    DOLLARS FUZZ
+ * Summary:
+ *    A libFuzzer target for the Dollars reader. Any input at all must
+ *    be read without crashing, and whatever was read must display as
+ *    text that reads back as the very same amount.
+ *
+ *    Built with clang and -fsanitize=fuzzer this is driven by libFuzzer.
+ *    Built with -DREPLAY it has its own main() that runs each file named
+ *    on the command line through the same check, so a crash found by
+ *    libFuzzer can be replayed with any compiler.
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#include <iostream>
+#include <sstream>     // for ISTRINGSTREAM and OSTRINGSTREAM
+#include <string>      // for STRING
+#include <cstdlib>     // for ABORT
+#include <cstdint>     // for UINT8_T
+#include "dollars.h"
+using namespace std;
+
+/*****************************************
+ * LLVM FUZZER TEST ONE INPUT
+ * Read every amount in the input, checking that each
+ * one survives being displayed and read again
+ *****************************************/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+   istringstream in(string((const char *)data, size));
+
+   // at most one amount per byte, so this always stops
+   for (size_t i = 0; i <= size && in.good(); i++)
+   {
+      Dollars read;
+      in >> read;
+
+      ostringstream text;
+      text << read;
+
+      istringstream again(text.str());
+      Dollars reread;
+      again >> reread;
+      if (read != reread)
+      {
+         cerr << "\"" << text.str() << "\" does not read back\n";
+         abort();
+      }
+
+      // skip what the reader would not take so we always make progress
+      if (in.good())
+         in.get();
+   }
+   return 0;
+}
+
+#ifdef REPLAY
+#include <fstream>     // for IFSTREAM
+
+/*****************************************
+ * MAIN - replay the files on the command line
+ *****************************************/
+int main(int argc, char ** argv)
+{
+   for (int i = 1; i < argc; i++)
+   {
+      ifstream fin(argv[i], ios::binary);
+      string bytes((istreambuf_iterator <char> (fin)),
+                   istreambuf_iterator <char> ());
+      LLVMFuzzerTestOneInput((const uint8_t *)bytes.data(), bytes.size());
+      cout << argv[i] << ": ok\n";
+   }
+   return 0;
+}
+#endif // REPLAY
@@ -0,0 +1,315 @@
+/***********************************************************************
+ * Header:
+ *    FIXED POINT
+ * Summary:
+ *    Money with a configurable number of decimal places. Dollars is
+ *    locked to whole cents; FixedPoint <4> keeps prices such as
+ *    $4.2113 without rounding them. The value is stored as a 64 bit
+ *    count of the smallest unit, and everything, including rounding,
+ *    is done in integer arithmetic. No doubles are involved.
+ *
+ *    This will contain the class definition of:
+ *        FixedPoint <Scale>  : money with Scale decimal places
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <iostream>  // for OSTREAM and ISTREAM
+#include <cassert>   // for ASSERT
+#include <cctype>    // for ISDIGIT and ISSPACE
+#include <climits>   // for INT_MAX and LLONG_MAX
+#include "dollars.h" // for DOLLARS
+
+/******************************************
+ * POWER OF TEN
+ * 10 to the n, computed by the compiler
+ ******************************************/
+constexpr long long powerOfTen(int n)
+{
+   return n == 0 ? 1 : 10 * powerOfTen(n - 1);
+}
+
+/******************************************
+ * DIVIDE AND ROUND
+ * Integer division rounding half away from zero:
+ *    15 / 10 --> 2      -15 / 10 --> -2      14 / 10 --> 1
+ ******************************************/
+inline long long divideAndRound(__int128 numerator, long long denominator)
+{
+   assert(denominator > 0);
+   __int128 quotient  = numerator / denominator;
+   __int128 remainder = numerator % denominator;
+   if (remainder < 0)
+      remainder = -remainder;
+   if (remainder * 2 >= denominator)
+      quotient += (numerator < 0 ? -1 : 1);
+   return (long long)quotient;
+}
+
+/******************************************
+ * FIXED POINT
+ * A number with exactly Scale decimal places. The same
+ * inputs as Dollars are accepted:
+ *   -4.1234 (4.1234) -$4.1234 $-4.1234
+ ******************************************/
+template <int Scale>
+class FixedPoint
+{
+   // 10 to the 18th is the largest power of ten a long long holds
+   static_assert(Scale >= 0 && Scale <= 18,
+                 "FixedPoint keeps from 0 to 18 decimal places");
+
+public:
+   // how many units make one dollar
+   static const long long ONE = powerOfTen(Scale);
+
+   // constructors
+   FixedPoint()                          : units(0)               {}
+   FixedPoint(const Dollars & dollars)   : units(0) { *this = dollars; }
+
+   // build from a raw count of the smallest unit
+   static FixedPoint fromUnits(long long units)
+   {
+      FixedPoint value;
+      value.units = units;
+      return value;
+   }
+   long long getUnits() const { return units; }
+
+   // to and from Dollars. Going to Dollars rounds to the nearest cent
+   // and throws if that is more cents than Dollars can hold
+   FixedPoint & operator = (const Dollars & dollars)
+   {
+      units = rescale(dollars.getCents(), 2, Scale);
+      return *this;
+   }
+   Dollars toDollars() const
+   {
+      long long cents = rescale(units, Scale, 2);
+      if (cents > INT_MAX || cents < -INT_MAX)
+         throw "ERROR: the amount is too large for Dollars";
+      return Dollars((int)cents);
+   }
+
+   // change the number of decimal places, rounding if there are fewer
+   template <int Other>
+   FixedPoint <Other> to() const
+   {
+      return FixedPoint <Other> ::fromUnits(rescale(units, Scale, Other));
+   }
+
+   // arithmetic
+   FixedPoint operator + (const FixedPoint & rhs) const
+   {
+      return fromUnits(units + rhs.units);
+   }
+   FixedPoint operator - (const FixedPoint & rhs) const
+   {
+      return fromUnits(units - rhs.units);
+   }
+   FixedPoint & operator += (const FixedPoint & rhs)
+   {
+      units += rhs.units;
+      return *this;
+   }
+   FixedPoint & operator -= (const FixedPoint & rhs)
+   {
+      units -= rhs.units;
+      return *this;
+   }
+   FixedPoint operator * (long long value) const
+   {
+      return fromUnits(units * value);
+   }
+   FixedPoint operator * (const FixedPoint & rhs) const
+   {
+      return fromUnits(divideAndRound((__int128)units * rhs.units, ONE));
+   }
+   FixedPoint operator / (long long value) const
+   {
+      assert(value != 0);
+      return fromUnits(value > 0 ? divideAndRound(units, value)
+                                 : divideAndRound(-(__int128)units, -value));
+   }
+
+   // comparisons
+   bool operator == (const FixedPoint & rhs) const { return units == rhs.units; }
+   bool operator != (const FixedPoint & rhs) const { return units != rhs.units; }
+   bool operator <  (const FixedPoint & rhs) const { return units <  rhs.units; }
+   bool operator <= (const FixedPoint & rhs) const { return units <= rhs.units; }
+   bool operator >  (const FixedPoint & rhs) const { return units >  rhs.units; }
+   bool operator >= (const FixedPoint & rhs) const { return units >= rhs.units; }
+
+   // parse from text, returning where the parse stopped
+   static const char * parse(const char * begin, const char * end,
+                             FixedPoint & rhs);
+
+   // format into a buffer that holds at least MAX_TEXT characters,
+   // returning how many characters were written
+   enum { MAX_TEXT = 32 };
+   int format(char * buffer) const;
+
+private:
+   // move a count of units from one number of decimal places to
+   // another. Throws if there are too many units to hold
+   static long long rescale(long long value, int from, int to)
+   {
+      if (to < from)
+         return divideAndRound(value, powerOfTen(from - to));
+      long long factor = powerOfTen(to - from);
+      if (value > LLONG_MAX / factor || value < -(LLONG_MAX / factor))
+         throw "ERROR: the amount is too large for that many decimal places";
+      return value * factor;
+   }
+
+   long long units;   // how many 1/ONE of a dollar
+};
+
+template <int Scale>
+const long long FixedPoint <Scale> :: ONE;
+
+/********************************************
+ * FIXED POINT PARSE
+ * Read money from text, the same way Dollars does:
+ *     - skips leading white spaces and $ signs
+ *     - negative values work with () or -
+ *     - every decimal place is consumed; those past
+ *       Scale are rounded rather than dropped
+ *     - amounts too large for a long long stop at the
+ *       largest one, as Dollars stops at the largest int
+ * For example, with a Scale of 4:
+ *   $1.34       -->  13400
+ *  $(4.21126)   --> -42113
+ *******************************************/
+template <int Scale>
+const char * FixedPoint <Scale> :: parse(const char * begin, const char * end,
+                                         FixedPoint & rhs)
+{
+   const char * p = begin;
+   rhs.units = 0;
+
+   while (p != end && (isspace((unsigned char)*p) || *p == '$'))
+      p++;
+
+   bool negative = false;
+   while (p != end && (*p == '-' || *p == '('))
+   {
+      negative = true;
+      p++;
+   }
+   while (p != end && *p == '$')
+      p++;
+
+   // dollars, checked before each digit so they cannot overflow
+   long long whole = 0;
+   bool tooLarge = false;
+   for (; p != end && isdigit((unsigned char)*p); p++)
+      if (whole > (LLONG_MAX - 9) / 10)
+         tooLarge = true;
+      else
+         whole = whole * 10 + (*p - '0');
+
+   // the decimal places we keep, then the first one we drop for rounding
+   long long fraction = 0;
+   int digits = 0;
+   bool roundUp = false;
+   if (p != end && *p == '.')
+   {
+      p++;
+      for (; p != end && isdigit((unsigned char)*p); p++)
+      {
+         if (digits < Scale)
+            fraction = fraction * 10 + (*p - '0');
+         else if (digits == Scale)
+            roundUp = (*p >= '5');
+         digits++;
+      }
+   }
+   if (digits < Scale)
+      fraction *= powerOfTen(Scale - digits);
+
+   // the fraction is less than ONE, so only the dollars can be too many
+   long long rest = fraction + (roundUp ? 1 : 0);
+   if (tooLarge || whole > (LLONG_MAX - rest) / ONE)
+      rhs.units = LLONG_MAX;
+   else
+      rhs.units = whole * ONE + rest;
+   if (negative)
+      rhs.units = -rhs.units;
+
+   if (p != end && *p == ')')
+      p++;
+   return p;
+}
+
+/********************************************
+ * FIXED POINT FORMAT
+ * Write the digits backwards into a small buffer then
+ * copy them out. Negative amounts get () like Dollars:
+ *   12345 with a Scale of 4  --> $1.2345
+ *  -50000 with a Scale of 4  --> $(5.0000)
+ *******************************************/
+template <int Scale>
+int FixedPoint <Scale> :: format(char * buffer) const
+{
+   char reverse[MAX_TEXT];
+   int length = 0;
+   unsigned long long value = (units < 0 ? 0ULL - (unsigned long long)units
+                                         : (unsigned long long)units);
+
+   if (units < 0)
+      reverse[length++] = ')';
+   for (int i = 0; i < Scale; i++, value /= 10)
+      reverse[length++] = (char)('0' + value % 10);
+   if (Scale > 0)
+      reverse[length++] = '.';
+   do
+   {
+      reverse[length++] = (char)('0' + value % 10);
+      value /= 10;
+   }
+   while (value);
+   if (units < 0)
+      reverse[length++] = '(';
+   reverse[length++] = '$';
+
+   assert(length <= MAX_TEXT);
+   for (int i = 0; i < length; i++)
+      buffer[i] = reverse[length - 1 - i];
+   return length;
+}
+
+/********************************************
+ * FIXED POINT DISPLAY
+ *******************************************/
+template <int Scale>
+std::ostream & operator << (std::ostream & out, const FixedPoint <Scale> & rhs)
+{
+   char buffer[FixedPoint <Scale> ::MAX_TEXT];
+   return out.write(buffer, rhs.format(buffer));
+}
+
+/********************************************
+ * FIXED POINT READ
+ * Collect one word from the stream and parse it
+ *******************************************/
+template <int Scale>
+std::istream & operator >> (std::istream & in, FixedPoint <Scale> & rhs)
+{
+   rhs = FixedPoint <Scale> ();
+   char buffer[FixedPoint <Scale> ::MAX_TEXT * 2];
+   int length = 0;
+
+   in >> std::ws;
+   while (length < (int)sizeof(buffer) && in.peek() != EOF &&
+          !isspace(in.peek()))
+      buffer[length++] = (char)in.get();
+
+   FixedPoint <Scale> ::parse(buffer, buffer + length, rhs);
+   return in;
+}
+
+#endif // FIXED_POINT_H
@@ -0,0 +1,114 @@
+/***********************************************************************
+ * Program:
+ *    JOURNAL BENCH
+ * Summary:
+ *    Encodes a random walk of lots with the journal codec, reports how
+ *    small it got, then times decoding it: into a buffer of rows, into
+ *    a Queue of lots, and from random rows by seeking. Speeds are in
+ *    bytes of Lot produced a second, which is what a replay would be
+ *    competing with the disk for.
+ *
+ *        journalBench [lots] [seed]
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#include <iostream>          // for COUT
+#include <random>            // for MT19937
+#include <chrono>            // for STEADY_CLOCK
+#include <cstdlib>           // for ATOL
+#include "journalCodec.h"    // for JOURNAL_ENCODER and JOURNAL_DECODER
+using namespace std;
+
+/*******************************************
+ * SECONDS SINCE
+ *******************************************/
+double secondsSince(const chrono::steady_clock::time_point & start)
+{
+   return chrono::duration <double> (chrono::steady_clock::now() - start)
+      .count();
+}
+
+/*******************************************
+ * MAKE LOTS
+ * Round lots around a price that wanders a few cents
+ * at a time, bought one after another
+ *******************************************/
+Queue <Lot> makeLots(long count, unsigned int seed)
+{
+   mt19937 random(seed);
+   Queue <Lot> lots((int)count);
+   int cents = 10000;
+   int seq = 0;
+   for (long i = 0; i < count; i++)
+   {
+      cents += (int)(random() % 9) - 4;
+      if (cents < 100)
+         cents = 100;
+      seq += 1 + (random() % 4 == 0);
+      lots.push(Lot((int)(random() % 10 + 1) * 100, Dollars(cents), seq));
+   }
+   return lots;
+}
+
+/**********************************************************************
+ * MAIN
+ * Encode once, then decode three ways
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   long count = (argc > 1 ? atol(argv[1]) : 10000000);
+   unsigned int seed = (argc > 2 ? atoi(argv[2]) : 1);
+   Queue <Lot> lots = makeLots(count, seed);
+   double bytes = (double)count * sizeof(Lot);
+
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   string encoding = encodeLots(lots);
+   double encodeSeconds = secondsSince(start);
+
+   // decoding into a buffer of rows that is used over and over
+   JournalDecoder decoder(encoding.data(), encoding.size());
+   JournalRow rows[1024];
+   long long checksum = 0;
+   start = chrono::steady_clock::now();
+   int got;
+   while ((got = decoder.next(rows, 1024)) > 0)
+      checksum += rows[got - 1].cents;
+   double decodeSeconds = secondsSince(start);
+
+   // decoding into a Queue that already has the room
+   Queue <Lot> replayed((int)count);
+   start = chrono::steady_clock::now();
+   decodeLots(encoding, replayed);
+   double replaySeconds = secondsSince(start);
+
+   // seeking to random rows and reading one
+   mt19937 random(seed);
+   int seeks = 10000;
+   start = chrono::steady_clock::now();
+   for (int i = 0; i < seeks; i++)
+   {
+      decoder.seek(random() % count);
+      decoder.next(rows, 1);
+      checksum += rows[0].seq;
+   }
+   double seekSeconds = secondsSince(start);
+
+   bool same = (replayed.size() == lots.size());
+   for (Lot lot; same && replayed.tryPop(lot); lots.pop())
+      same = lot.shares == lots.front().shares &&
+             lot.price  == lots.front().price  &&
+             lot.seq    == lots.front().seq;
+
+   cout << count << " lots, " << encoding.size() << " bytes: "
+        << (double)encoding.size() / count << " bytes/lot, "
+        << bytes / encoding.size() << "x smaller than raw\n";
+   cout << "encode\t" << bytes / encodeSeconds / 1e9 << " GB/s\n";
+   cout << "decode\t" << bytes / decodeSeconds / 1e9 << " GB/s\n";
+   cout << "replay\t" << bytes / replaySeconds / 1e9
+        << " GB/s into Queue <Lot>\n";
+   cout << "seek\t" << seekSeconds * 1e6 / seeks << " us/seek\t"
+        << "(checksum " << checksum << ")\n";
+   cout << "lots " << (same ? "match\n" : "DIFFER\n");
+   return same ? 0 : 1;
+}
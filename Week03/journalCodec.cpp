@@ -0,0 +1,370 @@
+/***********************************************************************
+ * Implementation:
+ *    JOURNAL CODEC
+ * Summary:
+ *    Delta and zigzag varint columns in indexed blocks
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cstring>           // for MEMCMP
+#include <algorithm>         // for UPPER_BOUND
+#include "journalCodec.h"    // for JOURNAL_ENCODER and JOURNAL_DECODER
+using namespace std;
+
+// what a block and the footer start and end with
+const char BLOCK_MAGIC[]  = "JBLK";
+const char FOOTER_MAGIC[] = "JIDX";
+
+// the footer: index offset, block count, magic
+const size_t FOOTER_SIZE = 8 + 8 + 4;
+
+// a block header, and the length in front of each column
+const size_t BLOCK_HEADER = 4 + 4;
+const size_t COLUMN_HEADER = 4;
+
+// no 32 bit number takes more than this many varint bytes. The footer
+// is longer, so a varint started inside a block never runs off the end
+const int MAX_VARINT = 5;
+static_assert(FOOTER_SIZE >= MAX_VARINT, "a varint must fit in the footer");
+
+// blocks bigger than this are corrupt, not real
+const uint32_t MAX_BLOCK_ROWS = 1 << 24;
+
+/********************************************
+ * PUT and GET
+ * Little endian numbers whatever the machine is
+ *******************************************/
+static void put32(string & out, uint32_t value)
+{
+   for (int i = 0; i < 4; i++)
+      out += (char)(value >> (8 * i));
+}
+
+static void put64(string & out, uint64_t value)
+{
+   for (int i = 0; i < 8; i++)
+      out += (char)(value >> (8 * i));
+}
+
+static uint32_t get32(const unsigned char * p)
+{
+   return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+          (uint32_t)p[3] << 24;
+}
+
+static uint64_t get64(const unsigned char * p)
+{
+   return (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+/********************************************
+ * ZIGZAG
+ * -1 becomes 1, 1 becomes 2, -2 becomes 3, and so on.
+ * Done on unsigned numbers so nothing can overflow
+ *******************************************/
+static uint32_t zigzag(uint32_t delta)
+{
+   return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+static uint32_t unzigzag(uint32_t value)
+{
+   return (value >> 1) ^ (0u - (value & 1));
+}
+
+/********************************************
+ * PUT VARINT
+ * Seven bits a byte, low bits first, the high bit
+ * set on every byte but the last
+ *******************************************/
+static void putVarint(string & out, uint32_t value)
+{
+   while (value >= 0x80)
+   {
+      out += (char)(value | 0x80);
+      value >>= 7;
+   }
+   out += (char)value;
+}
+
+/********************************************
+ * GET VARINT
+ * Reads as many as MAX_VARINT bytes. Nearly every
+ * value is one byte, so that comes first
+ *******************************************/
+static inline const unsigned char * getVarint(const unsigned char * p,
+                                              uint32_t & value)
+{
+   uint32_t byte = *p++;
+   if (byte < 0x80)
+   {
+      value = byte;
+      return p;
+   }
+   value = byte & 0x7f;
+   for (int shift = 7; shift < 35; shift += 7)
+   {
+      byte = *p++;
+      value |= (byte & 0x7f) << shift;
+      if (byte < 0x80)
+         return p;
+   }
+   throw "ERROR: the journal has a bad number in it";
+}
+
+/********************************************
+ * DECODE COLUMN
+ * One field of every row in a block. "delta" columns
+ * add each value to the one before. Every block is
+ * followed by at least the footer, so a varint that
+ * starts inside the column can be read whole without
+ * running off the end of the encoding
+ *******************************************/
+static void decodeColumn(const unsigned char * p, const unsigned char * end,
+                         JournalRow * rows, int count,
+                         int JournalRow::*field, bool delta)
+{
+   uint32_t previous = 0;
+   uint32_t value;
+   for (int i = 0; i < count; i++)
+   {
+      if (p >= end)
+         throw "ERROR: the journal ends in the middle of a column";
+      p = getVarint(p, value);
+      previous = (delta ? previous + unzigzag(value) : value);
+      rows[i].*field = (int)previous;
+   }
+
+   if (p != end)
+      throw "ERROR: the journal has a column of the wrong length";
+}
+
+/********************************************
+ * JOURNAL ENCODER : NON-DEFAULT CONSTRUCTOR
+ *******************************************/
+JournalEncoder :: JournalEncoder(int blockRows) :
+   blockRows(blockRows), rows(0), finished(false)
+{
+   if (blockRows < 1 || blockRows > (int)MAX_BLOCK_ROWS)
+      throw "ERROR: a journal block must hold at least one row";
+   pending.reserve(blockRows);
+}
+
+/********************************************
+ * JOURNAL ENCODER :: WRITE BLOCK
+ * The header, then each column with its length in
+ * front so a reader can tell where the next one starts
+ *******************************************/
+void JournalEncoder :: writeBlock()
+{
+   if (pending.empty())
+      return;
+
+   firstRows.push_back(rows);
+   offsets.push_back(out.size());
+   out.append(BLOCK_MAGIC, 4);
+   put32(out, (uint32_t)pending.size());
+
+   int JournalRow::*fields[] = { &JournalRow::kind, &JournalRow::shares,
+                                 &JournalRow::cents, &JournalRow::seq };
+   for (int f = 0; f < 4; f++)
+   {
+      bool delta = (f != 0);
+      uint32_t previous = 0;
+      column.clear();
+      for (size_t i = 0; i < pending.size(); i++)
+      {
+         uint32_t value = (uint32_t)(pending[i].*fields[f]);
+         putVarint(column, delta ? zigzag(value - previous) : value);
+         previous = value;
+      }
+      put32(out, (uint32_t)column.size());
+      out += column;
+   }
+
+   rows += pending.size();
+   pending.clear();
+}
+
+/********************************************
+ * JOURNAL ENCODER :: FINISH
+ * Only the first call writes anything
+ *******************************************/
+const string & JournalEncoder :: finish()
+{
+   if (finished)
+      return out;
+   finished = true;
+   writeBlock();
+
+   uint64_t indexOffset = out.size();
+   for (size_t i = 0; i < offsets.size(); i++)
+   {
+      put64(out, firstRows[i]);
+      put64(out, offsets[i]);
+   }
+   put64(out, indexOffset);
+   put64(out, offsets.size());
+   out.append(FOOTER_MAGIC, 4);
+   return out;
+}
+
+/********************************************
+ * JOURNAL DECODER : NON-DEFAULT CONSTRUCTOR
+ * Everything the index says is checked here, so a
+ * block that is read later is at least in bounds
+ *******************************************/
+JournalDecoder :: JournalDecoder(const char * data, size_t size) :
+   data((const unsigned char *)data), size(size), totalRows(0),
+   current(-1), position(0)
+{
+   if (size < FOOTER_SIZE ||
+       memcmp(data + size - 4, FOOTER_MAGIC, 4) != 0)
+      throw "ERROR: this is not a journal";
+
+   const unsigned char * footer = this->data + size - FOOTER_SIZE;
+   uint64_t indexOffset = get64(footer);
+   uint64_t blocks = get64(footer + 8);
+   if (indexOffset > size - FOOTER_SIZE ||
+       (size - FOOTER_SIZE - indexOffset) / 16 != blocks ||
+       (size - FOOTER_SIZE - indexOffset) % 16 != 0)
+      throw "ERROR: the journal index is damaged";
+
+   const unsigned char * entry = this->data + indexOffset;
+   for (uint64_t i = 0; i < blocks; i++, entry += 16)
+   {
+      uint64_t first  = get64(entry);
+      uint64_t offset = get64(entry + 8);
+      if (first != (uint64_t)totalRows ||
+          indexOffset < BLOCK_HEADER ||
+          offset > indexOffset - BLOCK_HEADER ||
+          (i > 0 && offset <= offsets.back()) ||
+          memcmp(data + offset, BLOCK_MAGIC, 4) != 0)
+         throw "ERROR: the journal index is damaged";
+
+      uint32_t count = get32(this->data + offset + 4);
+      if (count == 0 || count > MAX_BLOCK_ROWS)
+         throw "ERROR: the journal index is damaged";
+      firstRows.push_back(first);
+      offsets.push_back(offset);
+      totalRows += count;
+   }
+   blocksEnd = indexOffset;
+}
+
+/********************************************
+ * JOURNAL DECODER :: SEEK
+ * Find the last block that starts at or before the row
+ *******************************************/
+void JournalDecoder :: seek(long long row)
+{
+   if (row < 0 || row > totalRows)
+      throw "ERROR: no such row in the journal";
+
+   if (row == totalRows)
+   {
+      current = getBlocks();
+      position = 0;
+      block.clear();
+      return;
+   }
+
+   int index = (int)(upper_bound(firstRows.begin(), firstRows.end(),
+                                 (uint64_t)row) - firstRows.begin()) - 1;
+   if (index != current)
+      readBlock(index);
+   position = (int)(row - (long long)firstRows[index]);
+}
+
+/********************************************
+ * JOURNAL DECODER :: NEXT
+ * Move on to the next block when this one is used up
+ *******************************************/
+int JournalDecoder :: next(JournalRow * rows, int max)
+{
+   if (current < 0)
+      seek(0);
+
+   int count = 0;
+   while (count < max)
+   {
+      if (position == (int)block.size())
+      {
+         if (current + 1 >= getBlocks())
+            break;
+         readBlock(current + 1);
+         position = 0;
+      }
+
+      int take = (int)block.size() - position;
+      if (take > max - count)
+         take = max - count;
+      memcpy((void *)(rows + count), (const void *)&block[position],
+             take * sizeof(JournalRow));
+      count += take;
+      position += take;
+   }
+   return count;
+}
+
+/********************************************
+ * JOURNAL DECODER :: READ BLOCK
+ * Decode every column of one block, checking that each
+ * one is inside the block and holds exactly its rows
+ *******************************************/
+void JournalDecoder :: readBlock(int index)
+{
+   const unsigned char * p = data + offsets[index];
+   const unsigned char * end = data + (index + 1 < getBlocks() ?
+                                       offsets[index + 1] : blocksEnd);
+   int count = (int)get32(p + 4);
+   p += BLOCK_HEADER;
+
+   current = -1;
+   block.resize(count);
+   int JournalRow::*fields[] = { &JournalRow::kind, &JournalRow::shares,
+                                 &JournalRow::cents, &JournalRow::seq };
+   for (int f = 0; f < 4; f++)
+   {
+      if ((size_t)(end - p) < COLUMN_HEADER ||
+          get32(p) > (size_t)(end - p) - COLUMN_HEADER)
+         throw "ERROR: the journal has a column of the wrong length";
+      const unsigned char * columnEnd = p + COLUMN_HEADER + get32(p);
+      decodeColumn(p + COLUMN_HEADER, columnEnd, &block[0], count,
+                   fields[f], f != 0);
+      p = columnEnd;
+   }
+   if (p != end)
+      throw "ERROR: the journal has a block of the wrong length";
+
+   current = index;
+   position = 0;
+}
+
+/********************************************
+ * ENCODE LOTS
+ * The Queue is a copy, so it can be emptied as we go
+ *******************************************/
+string encodeLots(Queue <Lot> lots)
+{
+   JournalEncoder encoder;
+   Lot lot;
+   while (lots.tryPop(lot))
+      encoder.add(JournalRow(0, lot.shares, lot.price.getCents(), lot.seq));
+   return encoder.finish();
+}
+
+/********************************************
+ * DECODE LOTS
+ * A block at a time, straight onto the Queue
+ *******************************************/
+void decodeLots(const string & encoding, Queue <Lot> & lots)
+{
+   JournalDecoder decoder(encoding.data(), encoding.size());
+   JournalRow rows[1024];
+   int count;
+   while ((count = decoder.next(rows, 1024)) > 0)
+      for (int i = 0; i < count; i++)
+         lots.push(Lot(rows[i].shares, Dollars(rows[i].cents), rows[i].seq));
+}
@@ -0,0 +1,141 @@
+/***********************************************************************
+ * Header:
+ *    JOURNAL CODEC
+ * Summary:
+ *    A compact encoding for streams of trades and lots. Rows are cut
+ *    into blocks, and each block stores its rows a column at a time:
+ *    the kinds, then the share counts, the prices in cents, and the
+ *    sequence numbers. Share counts, prices, and sequence numbers are
+ *    stored as the difference from the row before, zigzagged so small
+ *    negative differences are small numbers too, and written as
+ *    varints. A random walk of prices costs a byte or two a row.
+ *
+ *    Each block starts its differences over, so it can be decoded on
+ *    its own. An index of where each block starts is written after the
+ *    last one, so a reader can seek to any row by decoding one block.
+ *
+ *        block  : "JBLK" rows  then for each of the four columns:
+ *                                   bytes  varints...
+ *        index  : for each block:   first row  offset
+ *        footer : index offset  blocks  "JIDX"
+ *
+ *    Numbers outside the varints are little endian: 4 bytes each,
+ *    except the rows and offsets in the index and footer which are 8.
+ *
+ *    This will contain the class definitions of:
+ *        JournalRow       : one trade or lot
+ *        JournalEncoder   : rows to bytes
+ *        JournalDecoder   : bytes back to rows, from any row
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef JOURNAL_CODEC_H
+#define JOURNAL_CODEC_H
+
+#include <cassert>       // for ASSERT
+#include <cstddef>       // for SIZE_T
+#include <cstdint>       // for UINT32_T
+#include <string>        // for STRING
+#include <vector>        // for VECTOR
+#include "queue.h"       // for QUEUE
+#include "lotQueue.h"    // for LOT
+
+/******************************************
+ * JOURNAL ROW
+ * One trade (a kind, shares, a price, and its number)
+ * or one lot (shares, a price, and the buy that made it)
+ ******************************************/
+struct JournalRow
+{
+   JournalRow() : kind(0), shares(0), cents(0), seq(0) {}
+   JournalRow(int kind, int shares, int cents, int seq) :
+      kind(kind), shares(shares), cents(cents), seq(seq) {}
+
+   int kind;      // what the caller says it is; 0 for a lot
+   int shares;
+   int cents;
+   int seq;
+};
+
+/******************************************
+ * JOURNAL ENCODER
+ * Collects rows and writes out a block whenever
+ * "blockRows" of them are waiting
+ ******************************************/
+class JournalEncoder
+{
+public:
+   // non-default constructor : how many rows go in a block
+   JournalEncoder(int blockRows = 4096);
+
+   // add one row. Not after finish()
+   void add(const JournalRow & row)
+   {
+      assert(!finished);
+      pending.push_back(row);
+      if ((int)pending.size() == blockRows)
+         writeBlock();
+   }
+
+   // write the last block and the index. Returns the whole encoding
+   const std::string & finish();
+
+private:
+   // encode the pending rows as one block
+   void writeBlock();
+
+   int blockRows;                         // rows per block
+   std::vector <JournalRow> pending;      // not in a block yet
+   std::vector <uint64_t> firstRows;      // the index: where each
+   std::vector <uint64_t> offsets;        //    block starts
+   uint64_t rows;                         // rows in finished blocks
+   std::string out;                       // the encoding so far
+   std::string column;                    // one column being built
+   bool finished;                         // has the index been written?
+};
+
+/******************************************
+ * JOURNAL DECODER
+ * Reads rows back out of an encoding, a block at a
+ * time. The encoding is not copied, so it has to
+ * outlive the decoder
+ ******************************************/
+class JournalDecoder
+{
+public:
+   // non-default constructor : check the footer and read the index.
+   // Throws if it is not a journal
+   JournalDecoder(const char * data, size_t size);
+
+   // how many rows and blocks there are
+   long long getRows() const   { return totalRows;                }
+   int getBlocks() const       { return (int)offsets.size();      }
+
+   // continue from row "row", which may be getRows() for the end
+   void seek(long long row);
+
+   // copy out up to "max" rows. Returns how many; 0 at the end
+   int next(JournalRow * rows, int max);
+
+private:
+   // decode block "index" into "block"
+   void readBlock(int index);
+
+   const unsigned char * data;            // the whole encoding
+   size_t size;                           // how long it is
+   std::vector <uint64_t> firstRows;      // the index
+   std::vector <uint64_t> offsets;
+   size_t blocksEnd;                      // where the index starts
+   long long totalRows;                   // rows in every block
+   std::vector <JournalRow> block;        // the current block, decoded
+   int current;                           // which block that is
+   int position;                          // the next row in it
+};
+
+// the lots in a Queue, front first, and back again. decodeLots()
+// pushes onto whatever the Queue already holds
+std::string encodeLots(Queue <Lot> lots);
+void decodeLots(const std::string & encoding, Queue <Lot> & lots);
+
+#endif // JOURNAL_CODEC_H
@@ -0,0 +1,292 @@
+/***********************************************************************
+* Header:
+*    LARGE QUEUE
+* Summary:
+*    A Queue for backlogs measured in gigabytes. Queue gets its buffer
+*    from new T[], which spreads it over 4K pages on whichever NUMA
+*    node happens to touch it first, and grows by copying every item.
+*    A LargeQueue maps its buffer itself instead:
+*        - in 2MB pages, either transparent huge pages asked for with
+*          madvise(), or explicit ones from the hugetlb pool. The ring
+*          walk then needs one TLB entry per 2MB rather than per 4K
+*        - bound to one NUMA node with mbind(), if asked to be
+*        - grown with mremap(), which moves the pages rather than the
+*          bytes in them. Only the part of the ring that had wrapped
+*          around to the start of the buffer is copied
+*    Explicit huge pages fall back to transparent ones when the pool
+*    is empty or cannot be remapped; getPages() says what was used.
+*
+*    The pages are moved as raw bytes, so only trivially copyable types
+*    can be used.
+*
+*    This will contain the class definition of:
+*        LargeQueue       : a Queue of T in huge pages
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef LARGE_QUEUE_H
+#define LARGE_QUEUE_H
+
+#include <cassert>             // for ASSERT
+#include <cstddef>             // for SIZE_T
+#include <cstring>             // for MEMCPY
+#include <type_traits>         // for IS_TRIVIALLY_COPYABLE
+#include <sys/mman.h>          // for MMAP, MREMAP, and MADVISE
+#include <sys/syscall.h>       // for SYS_MBIND
+#include <unistd.h>            // for SYSCALL
+#include <linux/mempolicy.h>   // for MPOL_BIND
+
+/************************************************
+ * LARGE QUEUE
+ * A ring buffer of T in huge pages on one NUMA node
+ ***********************************************/
+template <class T>
+class LargeQueue
+{
+   static_assert(std::is_trivially_copyable <T> ::value,
+                 "LargeQueue items are moved as raw bytes");
+
+public:
+   // what the buffer is made of
+   enum Pages
+   {
+      NORMAL,        // 4K pages, as new T[] would give
+      TRANSPARENT,   // 2MB pages when the kernel can find them
+      EXPLICIT       // 2MB pages reserved in the hugetlb pool
+   };
+
+   // everything is mapped in multiples of this
+   static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+   static_assert(sizeof(T) <= HUGE_PAGE,
+                 "a LargeQueue item must fit in the smallest mapping");
+
+   // non-default constructor : room for at least "capacity" items,
+   // on NUMA node "node", or wherever the kernel likes if it is -1
+   LargeQueue(size_t capacity = 0, Pages pages = TRANSPARENT,
+              int node = -1);
+
+   // destructor : give the pages back
+   ~LargeQueue()            { if (data) munmap(data, bytes);        }
+
+   // how many items are in the queue
+   bool empty() const noexcept     { return countIn == countOut;    }
+   size_t size() const noexcept    { return countIn - countOut;     }
+   size_t capacity() const noexcept { return vCapacity;             }
+
+   // what the buffer is made of, which may be less than was asked for
+   Pages getPages() const noexcept { return pages;                  }
+   int getNode() const noexcept    { return node;                   }
+
+   // the items at either end
+   T & front();
+   T & back();
+
+   // add an item to the back, growing if it is full
+   void push(const T & t);
+
+   // remove an item from either end
+   void pop();
+   void popBack();
+
+   // copy out the front item and remove it. False if it is empty
+   bool tryPop(T & t) noexcept
+   {
+      if (empty())
+         return false;
+      t = data[countOut % vCapacity];
+      countOut++;
+      return true;
+   }
+
+   // empty it, keeping the pages
+   void clear() noexcept           { countIn = 0; countOut = 0;     }
+
+private:
+   // the buffer is the queue's own, so it cannot be copied
+   LargeQueue(const LargeQueue & rhs);
+   LargeQueue & operator = (const LargeQueue & rhs);
+
+   // map a new region of "size" bytes with the queue's pages and node
+   void * map(size_t size);
+
+   // double the buffer, keeping the items where they are
+   void grow();
+
+   T * data;            // the mapped buffer
+   size_t bytes;        // how big the mapping is
+   size_t vCapacity;    // how many items fit in it
+   size_t countIn;      // the number of items added to queue
+   size_t countOut;     // the number of items removed from queue
+   Pages pages;         // what the buffer is made of
+   int node;            // the NUMA node it is bound to, or -1
+};
+
+/**********************************************
+ * LARGE QUEUE : NON-DEFAULT CONSTRUCTOR
+ * Nothing is mapped until the first push if no
+ * capacity is asked for
+ **********************************************/
+template <class T>
+LargeQueue <T> :: LargeQueue(size_t capacity, Pages pages, int node) :
+   data(NULL), bytes(0), vCapacity(0), countIn(0), countOut(0),
+   pages(pages), node(node)
+{
+   assert(node >= -1 && node < (int)(8 * sizeof(unsigned long)));
+   if (capacity == 0)
+      return;
+
+   size_t length = (capacity * sizeof(T) + HUGE_PAGE - 1) / HUGE_PAGE *
+                   HUGE_PAGE;
+   data = (T *)map(length);
+   bytes = length;
+   vCapacity = bytes / sizeof(T);
+}
+
+/**********************************************
+ * LARGE QUEUE :: MAP
+ * Explicit huge pages come back aligned. Other pages are
+ * mapped with a huge page to spare and trimmed, so the
+ * kernel can back every 2MB of them with one huge page
+ **********************************************/
+template <class T>
+void * LargeQueue <T> :: map(size_t size)
+{
+   void * memory = MAP_FAILED;
+   if (pages == EXPLICIT)
+   {
+      memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (memory == MAP_FAILED)
+         pages = TRANSPARENT;
+   }
+
+   if (memory == MAP_FAILED)
+   {
+      size_t spare = (pages == NORMAL ? 0 : HUGE_PAGE);
+      char * region = (char *)mmap(NULL, size + spare,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (region == (char *)MAP_FAILED)
+         throw "ERROR: Unable to map the queue buffer";
+
+      char * aligned = region;
+      if (spare)
+      {
+         aligned = (char *)(((size_t)region + HUGE_PAGE - 1) /
+                            HUGE_PAGE * HUGE_PAGE);
+         if (aligned != region)
+            munmap(region, aligned - region);
+         if (aligned + size != region + size + spare)
+            munmap(aligned + size, region + spare - aligned);
+         madvise(aligned, size, MADV_HUGEPAGE);
+      }
+      memory = aligned;
+   }
+
+   // the pages are not touched yet, so they are all placed on the node
+   if (node >= 0)
+   {
+      unsigned long mask = 1UL << node;
+      if (syscall(SYS_mbind, memory, size, MPOL_BIND, &mask,
+                  8 * sizeof(mask) + 1, 0) != 0)
+      {
+         munmap(memory, size);
+         throw "ERROR: Unable to bind the queue to the NUMA node";
+      }
+   }
+   return memory;
+}
+
+/**********************************************
+ * LARGE QUEUE :: GROW
+ * Make a region twice the size, then move the old pages
+ * to the start of it with mremap(). Their contents come
+ * along without being copied. Afterwards the items that
+ * had wrapped to the front of the ring are copied to just
+ * past where the old buffer ended:
+ *
+ *   before   [ 4 5 . . 1 2 3 ]
+ *   after    [ . . . . 1 2 3 4 5 . . . . . ]
+ **********************************************/
+template <class T>
+void LargeQueue <T> :: grow()
+{
+   size_t length = (bytes == 0 ? HUGE_PAGE : bytes * 2);
+   T * bigger = (T *)map(length);
+
+   if (bytes != 0 &&
+       mremap(data, bytes, bytes, MREMAP_MAYMOVE | MREMAP_FIXED,
+              bigger) == MAP_FAILED)
+   {
+      // hugetlb pages may not be remappable here; copy instead
+      memcpy((void *)bigger, (const void *)data, bytes);
+      munmap(data, bytes);
+   }
+
+   size_t count = size();
+   size_t head = (vCapacity == 0 ? 0 : countOut % vCapacity);
+   size_t wrapped = (head + count > vCapacity ? head + count - vCapacity :
+                     0);
+   memcpy((void *)(bigger + vCapacity), (const void *)bigger,
+          wrapped * sizeof(T));
+
+   data = bigger;
+   bytes = length;
+   vCapacity = bytes / sizeof(T);
+   countOut = head;
+   countIn = head + count;
+}
+
+/**************************************
+ * LARGE QUEUE :: FRONT and BACK
+ ***************************************/
+template <class T>
+T & LargeQueue <T> :: front()
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   return data[countOut % vCapacity];
+}
+
+template <class T>
+T & LargeQueue <T> :: back()
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   return data[(countIn - 1) % vCapacity];
+}
+
+/**************************************
+ * LARGE QUEUE :: PUSH
+ ***************************************/
+template <class T>
+void LargeQueue <T> :: push(const T & t)
+{
+   if (size() == vCapacity)
+      grow();
+   data[countIn % vCapacity] = t;
+   countIn++;
+}
+
+/**************************************
+ * LARGE QUEUE :: POP and POP BACK
+ ***************************************/
+template <class T>
+void LargeQueue <T> :: pop()
+{
+   if (empty())
+      throw "ERROR: attempting to pop from an empty queue";
+   countOut++;
+}
+
+template <class T>
+void LargeQueue <T> :: popBack()
+{
+   if (empty())
+      throw "ERROR: attempting to pop from an empty queue";
+   countIn--;
+}
+
+#endif // LARGE_QUEUE_H
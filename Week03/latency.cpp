@@ -0,0 +1,184 @@
+/***********************************************************************
+ * Implementation:
+ *    LATENCY
+ * Summary:
+ *    Log-linear buckets, and a set of them for each thread
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <chrono>            // for STEADY_CLOCK
+#include "latency.h"         // for LATENCY_HISTOGRAM and LATENCY_RECORDER
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>       // for __RDTSC
+#endif
+using namespace std;
+
+// no recorder has this id, so an unused cache never matches
+thread_local LatencyRecorder::Cache LatencyRecorder::cache[2] =
+   { { 0, NULL }, { 0, NULL } };
+
+// the last id given to a recorder
+static atomic <uint64_t> lastId(0);
+
+// how long to measure the tick rate over before trusting it
+const long long CALIBRATE_NANOS = 10000000;
+
+/********************************************
+ * STEADY NANOS
+ *******************************************/
+static long long steadyNanos()
+{
+   return chrono::duration_cast <chrono::nanoseconds>
+      (chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the tick rate is measured from here, as the program starts
+static const uint64_t startTicks = LatencyRecorder::now();
+static const long long startNanos = steadyNanos();
+
+/********************************************
+ * LATENCY HISTOGRAM :: HIGHEST IN
+ * The reverse of bucketOf(): the bucket's first value,
+ * plus its width less one
+ *******************************************/
+uint64_t LatencyHistogram :: highestIn(int bucket)
+{
+   if (bucket < SUB_BUCKETS)
+      return bucket;
+   int shift = (bucket >> SUB_BITS) - 1;
+   uint64_t first = (uint64_t)(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1)))
+                    << shift;
+   return first + ((uint64_t)1 << shift) - 1;
+}
+
+/********************************************
+ * LATENCY HISTOGRAM :: PERCENTILE
+ * Walk the buckets until "fraction" of the values are
+ * behind us. The answer is the top of that bucket, so
+ * it is never less than the real value
+ *******************************************/
+long long LatencyHistogram :: percentile(double fraction) const
+{
+   if (total == 0)
+      return 0;
+
+   uint64_t wanted = (uint64_t)(fraction * (double)total + 0.5);
+   if (wanted < 1)
+      wanted = 1;
+   if (wanted > total)
+      wanted = total;
+
+   uint64_t seen = 0;
+   int bucket = 0;
+   for (; bucket < BUCKETS - 1; bucket++)
+   {
+      seen += counts[bucket];
+      if (seen >= wanted)
+         break;
+   }
+   return (long long)((double)highestIn(bucket) * nanosPerTick + 0.5);
+}
+
+/********************************************
+ * LATENCY RECORDER : NON-DEFAULT CONSTRUCTOR
+ * The tick rate is measured here, when the program is
+ * setting up, so a report never has to wait for it
+ *******************************************/
+LatencyRecorder :: LatencyRecorder(int kinds) :
+   kinds(kinds), id(++lastId)
+{
+   if (kinds < 1)
+      throw "ERROR: a latency recorder needs something to time";
+   nanosPerTick();
+}
+
+/********************************************
+ * LATENCY RECORDER :: NOW
+ * The time stamp counter where there is one. It counts
+ * at the same rate whatever the clock speed on anything
+ * recent, and reads in about half the time steady_clock
+ * does, even where that is served from the vDSO.
+ * latencyBench shows both
+ *******************************************/
+uint64_t LatencyRecorder :: now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   return (uint64_t)steadyNanos();
+#endif
+}
+
+/********************************************
+ * LATENCY RECORDER :: ATTACH
+ * The first time a thread records, or the first time
+ * since it recorded with two other recorders. The counts
+ * are never freed before the recorder is, so the cache
+ * can point into them without holding the lock
+ *******************************************/
+atomic <uint64_t> * LatencyRecorder :: attach()
+{
+   lock_guard <mutex> guard(lock);
+   Counts & counts = threads[this_thread::get_id()];
+   if (!counts)
+   {
+      size_t size = (size_t)kinds * LatencyHistogram::BUCKETS;
+      counts.reset(new atomic <uint64_t> [size]);
+      for (size_t i = 0; i < size; i++)
+         counts[i].store(0, memory_order_relaxed);
+   }
+   cache[1] = cache[0];
+   cache[0].owner = id;
+   cache[0].counts = counts.get();
+   return cache[0].counts;
+}
+
+/********************************************
+ * LATENCY RECORDER :: NANOS PER TICK
+ * Compare the ticks and the steady clock since the
+ * program started, once, waiting until enough time has
+ * gone by for the answer to be good to a few parts in a
+ * million. The first recorder made pays for the wait
+ *******************************************/
+double LatencyRecorder :: nanosPerTick()
+{
+#if defined(__x86_64__) || defined(__i386__)
+   static const double rate = []()
+   {
+      long long nanos;
+      while ((nanos = steadyNanos() - startNanos) < CALIBRATE_NANOS)
+         this_thread::yield();
+      uint64_t ticks = now() - startTicks;
+      return ticks == 0 ? 1.0 : (double)nanos / (double)ticks;
+   }();
+   return rate;
+#else
+   return 1.0;
+#endif
+}
+
+/********************************************
+ * LATENCY RECORDER :: MERGED
+ * Add up every thread's counts of one kind. A thread
+ * may be recording while we read, in which case we see
+ * its counts from a moment ago
+ *******************************************/
+LatencyHistogram LatencyRecorder :: merged(int kind) const
+{
+   LatencyHistogram histogram(nanosPerTick());
+   lock_guard <mutex> guard(lock);
+   for (map <thread::id, Counts> ::const_iterator it = threads.begin();
+        it != threads.end(); ++it)
+   {
+      const atomic <uint64_t> * counts =
+         it->second.get() + (size_t)kind * LatencyHistogram::BUCKETS;
+      for (int bucket = 0; bucket < LatencyHistogram::BUCKETS; bucket++)
+      {
+         uint64_t count = counts[bucket].load(memory_order_relaxed);
+         if (count)
+            histogram.add(bucket, count);
+      }
+   }
+   return histogram;
+}
@@ -0,0 +1,154 @@
+/***********************************************************************
+ * Header:
+ *    LATENCY
+ * Summary:
+ *    HDR style latency histograms cheap enough to leave on. A value
+ *    goes in a bucket found from its highest set bit and the next few
+ *    bits below it, so every bucket is within 1/64 of the values in it
+ *    whether they are nanoseconds or seconds, and recording is a count
+ *    of leading zeros, two shifts, and an add.
+ *
+ *    Times are read from the time stamp counter where there is one and
+ *    turned into nanoseconds only when a report is made, at a rate
+ *    measured once for the whole program. Each thread records into
+ *    histograms of its own, so recording never takes a lock or shares
+ *    a cache line; a report adds them all together.
+ *
+ *    This will contain the class definitions of:
+ *        LatencyHistogram : counts of values, and their percentiles
+ *        LatencyRecorder  : a histogram per kind per thread
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <atomic>        // for ATOMIC
+#include <cstdint>       // for UINT64_T
+#include <map>           // for MAP
+#include <memory>        // for UNIQUE_PTR
+#include <mutex>         // for MUTEX
+#include <thread>        // for THREAD::ID
+#include <vector>        // for VECTOR
+
+/******************************************
+ * LATENCY HISTOGRAM
+ * How many values fell in each bucket. The values are
+ * ticks; "nanosPerTick" turns them into nanoseconds
+ ******************************************/
+class LatencyHistogram
+{
+public:
+   // 64 buckets for each power of two, up to 2^40 ticks
+   enum { SUB_BITS = 6, SUB_BUCKETS = 1 << SUB_BITS,
+          MAX_BITS = 40, BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS };
+
+   // default constructor : nothing counted
+   LatencyHistogram(double nanosPerTick = 1.0) :
+      counts(BUCKETS, 0), total(0), nanosPerTick(nanosPerTick) {}
+
+   // the bucket a value goes in. Bigger values go in the last one
+   static int bucketOf(uint64_t value)
+   {
+      if (value < SUB_BUCKETS)
+         return (int)value;
+      if (value >> MAX_BITS)
+         return BUCKETS - 1;
+      int shift = 63 - __builtin_clzll(value) - SUB_BITS;
+      return ((shift + 1) << SUB_BITS) + (int)(value >> shift) - SUB_BUCKETS;
+   }
+
+   // the biggest value that goes in a bucket
+   static uint64_t highestIn(int bucket);
+
+   // count a value, or add in another histogram's counts
+   void record(uint64_t value)     { counts[bucketOf(value)]++; total++; }
+   void add(int bucket, uint64_t count)
+   {
+      counts[bucket] += count;
+      total += count;
+   }
+
+   // how many values were counted
+   uint64_t getCount() const       { return total;                    }
+
+   // the value that "fraction" of the values are at or below, and the
+   // biggest value, both in nanoseconds. Zero if nothing was counted
+   long long percentile(double fraction) const;
+   long long max() const           { return percentile(1.0);          }
+
+private:
+   std::vector <uint64_t> counts;   // one for each bucket
+   uint64_t total;                  // the sum of the counts
+   double nanosPerTick;             // what a value is in nanoseconds
+};
+
+/******************************************
+ * LATENCY RECORDER
+ * A histogram for each of "kinds" kinds of thing on
+ * each thread that records one, added up on demand
+ ******************************************/
+class LatencyRecorder
+{
+public:
+   // non-default constructor : how many kinds are timed. Measures the
+   // tick rate if no recorder has yet
+   LatencyRecorder(int kinds);
+
+   // the time now, in ticks
+   static uint64_t now();
+
+   // nanoseconds for each tick, measured once from when the program
+   // started. The first call, made by the first recorder constructed,
+   // waits if that was only a moment ago
+   static double nanosPerTick();
+
+   // count one thing of a kind that took "ticks"
+   void record(int kind, uint64_t ticks)
+   {
+      std::atomic <uint64_t> * counts =
+         (cache[0].owner == id ? cache[0].counts :
+          cache[1].owner == id ? cache[1].counts : attach());
+      std::atomic <uint64_t> & count =
+         counts[kind * LatencyHistogram::BUCKETS +
+                LatencyHistogram::bucketOf(ticks)];
+      count.store(count.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+   }
+
+   // everything every thread has counted of one kind
+   LatencyHistogram merged(int kind) const;
+
+   // how many kinds there are
+   int getKinds() const            { return kinds;                    }
+
+private:
+   // the counts of one thread: a histogram for each kind in a row
+   typedef std::unique_ptr <std::atomic <uint64_t> []> Counts;
+
+   // a recorder this thread used, and its counts there
+   struct Cache
+   {
+      uint64_t owner;
+      std::atomic <uint64_t> * counts;
+   };
+
+   // no copying; the threads' caches point into the counts
+   LatencyRecorder(const LatencyRecorder & rhs);
+   LatencyRecorder & operator = (const LatencyRecorder & rhs);
+
+   // find or make this thread's counts and remember them in the cache
+   std::atomic <uint64_t> * attach();
+
+   // the last two recorders this thread used, newest first, so a
+   // thread recording into its own and a shared one never misses
+   static thread_local Cache cache[2];
+
+   int kinds;                                  // histograms per thread
+   uint64_t id;                                // never reused
+   mutable std::mutex lock;                    // protects "threads"
+   std::map <std::thread::id, Counts> threads; // every thread's counts
+};
+
+#endif // LATENCY_H
@@ -0,0 +1,130 @@
+/***********************************************************************
+ * Program:
+ *    LATENCY BENCH
+ * Summary:
+ *    What timing a command costs the stock program: reading the clock,
+ *    next to reading steady_clock instead, recording a value in the
+ *    histograms, and both together the way PortfolioHistory::apply()
+ *    does it, on one thread and on several at once. Then the same
+ *    trades through a PortfolioHistory, with the latency report it
+ *    gives at the end.
+ *
+ *        latencyBench [records] [threads]
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#include <iostream>          // for COUT
+#include <chrono>            // for STEADY_CLOCK
+#include <cstdlib>           // for ATOL
+#include <thread>            // for THREAD
+#include <vector>            // for VECTOR
+#include "latency.h"         // for LATENCY_RECORDER
+#include "stock.h"           // for PORTFOLIO_HISTORY
+using namespace std;
+
+/*******************************************
+ * SECONDS SINCE
+ *******************************************/
+double secondsSince(const chrono::steady_clock::time_point & start)
+{
+   return chrono::duration <double> (chrono::steady_clock::now() - start)
+      .count();
+}
+
+/*******************************************
+ * RECORD MANY
+ * Time "count" empty commands into a recorder. The sum
+ * keeps the compiler from leaving the clock reads out
+ *******************************************/
+uint64_t recordMany(LatencyRecorder & recorder, long count)
+{
+   uint64_t sum = 0;
+   for (long i = 0; i < count; i++)
+   {
+      uint64_t start = LatencyRecorder::now();
+      uint64_t ticks = LatencyRecorder::now() - start;
+      recorder.record((int)(i & 3), ticks);
+      sum += ticks;
+   }
+   return sum;
+}
+
+/**********************************************************************
+ * MAIN
+ * Each cost alone, then together, then in the stock program
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   long count = (argc > 1 ? atol(argv[1]) : 50000000);
+   int threadCount = (argc > 2 ? atoi(argv[2]) : 4);
+   LatencyRecorder recorder(4);
+   uint64_t sum = 0;
+
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (long i = 0; i < count; i++)
+      sum += LatencyRecorder::now();
+   double nowSeconds = secondsSince(start);
+
+   start = chrono::steady_clock::now();
+   for (long i = 0; i < count; i++)
+      sum += chrono::steady_clock::now().time_since_epoch().count();
+   double steadySeconds = secondsSince(start);
+
+   start = chrono::steady_clock::now();
+   for (long i = 0; i < count; i++)
+      recorder.record((int)(i & 3), (uint64_t)i * 2654435761u >> 40);
+   double recordSeconds = secondsSince(start);
+
+   start = chrono::steady_clock::now();
+   sum += recordMany(recorder, count);
+   double bothSeconds = secondsSince(start);
+
+   // every thread records as fast as it can into the same recorder
+   vector <thread> threads;
+   start = chrono::steady_clock::now();
+   for (int t = 0; t < threadCount; t++)
+      threads.push_back(thread([&]() { recordMany(recorder, count); }));
+   for (int t = 0; t < threadCount; t++)
+      threads[t].join();
+   double threadSeconds = secondsSince(start);
+
+   long merged = 0;
+   for (int kind = 0; kind < 4; kind++)
+      merged += (long)recorder.merged(kind).getCount();
+
+   cout << "now\t" << nowSeconds * 1e9 / count << " ns\n";
+   cout << "steady\t" << steadySeconds * 1e9 / count << " ns\n";
+   cout << "record\t" << recordSeconds * 1e9 / count << " ns\n";
+   cout << "both\t" << bothSeconds * 1e9 / count << " ns\n";
+   cout << threadCount << " threads\t" << threadSeconds * 1e9 / count
+        << " ns a record on each\t(checksum " << sum % 1000 << ")\n";
+
+   // the same thing as the stock program sees it
+   PortfolioHistory portfolio;
+   Queue <Event> events;
+   for (long i = 0; i < count / 50; i++)
+   {
+      Command command;
+      command.type = (i % 3 == 2 ? Command::SELL : Command::BUY);
+      command.shares = 10;
+      command.price = Dollars(100 + (int)(i % 7));
+      portfolio.apply(command, events);
+      if (i % 100 == 0)
+      {
+         command.type = Command::DISPLAY;
+         portfolio.apply(command, events);
+      }
+      events.clear();
+   }
+   Command stats;
+   stats.type = Command::STATS;
+   portfolio.apply(stats, events);
+   Event event;
+   while (events.tryPop(event))
+      cout << event;
+
+   bool counted = (merged == count * (2 + threadCount));
+   cout << "records " << (counted ? "all counted\n" : "LOST\n");
+   return counted ? 0 : 1;
+}
@@ -0,0 +1,418 @@
+/***********************************************************************
+* Header:
+*    LOT BOOK
+* Summary:
+*    The lots we hold, kept in the order a cost-basis strategy sells
+*    them. The strategy is a template parameter so it is chosen when
+*    the program is compiled and each book only carries what its
+*    strategy needs:
+*        Fifo        : oldest lot first, the front of a LotQueue
+*        Lifo        : newest lot first, the back of the same LotQueue
+*        Hifo        : most expensive lot first, an indexed heap
+*        SpecificLot : any lot by its sequence id, oldest otherwise
+*        SharedFifo  : oldest lot first, in a CowQueue so a copy of
+*                      the book is a snapshot that costs O(1)
+*
+*    This will contain the class definition of:
+*        LotHeap <Before> : a heap of lots that can find a lot by id
+*        LotBook <Strategy> : the lots, in the order they are sold
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef LOT_BOOK_H
+#define LOT_BOOK_H
+
+#include <cassert>
+#include <vector>      // for VECTOR
+#include <unordered_map>   // for UNORDERED_MAP
+#include "lotQueue.h"  // for LOT and LOT_QUEUE
+#include "cowQueue.h"  // for COW_QUEUE
+
+// the cost-basis strategies
+struct Fifo        {};
+struct Lifo        {};
+struct Hifo        {};
+struct SpecificLot {};
+struct SharedFifo  {};
+
+/************************************************
+ * HIGHER PRICE
+ * Sell the most expensive lot first, the oldest of those on a tie
+ ***********************************************/
+struct HigherPrice
+{
+   bool operator () (const Lot & lhs, const Lot & rhs) const
+   {
+      if (lhs.price != rhs.price)
+         return lhs.price > rhs.price;
+      return lhs.seq < rhs.seq;
+   }
+};
+
+/************************************************
+ * OLDER LOT
+ * Sell the oldest lot first
+ ***********************************************/
+struct OlderLot
+{
+   bool operator () (const Lot & lhs, const Lot & rhs) const
+   {
+      return lhs.seq < rhs.seq;
+   }
+};
+
+/************************************************
+ * LOT HEAP
+ * A binary heap of lots with the lot that "Before" puts
+ * first on top. It also remembers where each lot is in the
+ * heap, by sequence id, so any lot can be found or removed
+ * in O(log n). Only open lots are remembered, so a book
+ * that has traded for a long time is no bigger for it
+ ***********************************************/
+template <class Before>
+class LotHeap
+{
+public:
+   bool empty() const   { return heap.empty();          }
+   int size() const     { return (int)heap.size();      }
+
+   // add a lot. Sequence ids must be unique and not negative
+   void push(const Lot & lot);
+
+   // the lot that sells next
+   Lot top() const
+   {
+      if (heap.empty())
+         throw "ERROR: attempting to access an item in an empty heap";
+      return heap[0];
+   }
+
+   // is the lot with this sequence id in the heap?
+   bool contains(int seq) const
+   {
+      return where.find(seq) != where.end();
+   }
+
+   // the lot with this sequence id
+   Lot find(int seq) const
+   {
+      std::unordered_map <int, int> ::const_iterator it = where.find(seq);
+      if (it == where.end())
+         throw "ERROR: no lot with that sequence id";
+      return heap[it->second];
+   }
+
+   // sell part of a lot, removing it once it is used up
+   void take(int seq, int number);
+
+   // the sum of shares times price, in cents
+   long long value() const;
+
+private:
+   void swapAt(int i, int j);
+   void siftUp(int i);
+   void siftDown(int i);
+
+   std::vector <Lot> heap;    // the lots, heap[0] sells next
+   std::unordered_map <int, int> where;   // each open lot's index, by seq
+};
+
+/**************************************
+ * LOT HEAP :: PUSH
+ ***************************************/
+template <class Before>
+void LotHeap <Before> :: push(const Lot & lot)
+{
+   assert(lot.seq >= 0 && !contains(lot.seq));
+   heap.push_back(lot);
+   try
+   {
+      where[lot.seq] = size() - 1;
+   }
+   catch (...)
+   {
+      heap.pop_back();
+      throw;
+   }
+   siftUp(size() - 1);
+}
+
+/**************************************
+ * LOT HEAP :: TAKE
+ * Fewer shares does not change where a lot belongs; only
+ * removing it means moving the last lot into its place
+ ***************************************/
+template <class Before>
+void LotHeap <Before> :: take(int seq, int number)
+{
+   std::unordered_map <int, int> ::iterator it = where.find(seq);
+   if (it == where.end())
+      throw "ERROR: no lot with that sequence id";
+   int i = it->second;
+   assert(number > 0 && number <= heap[i].shares);
+
+   heap[i].shares -= number;
+   if (heap[i].shares > 0)
+      return;
+
+   swapAt(i, size() - 1);
+   where.erase(seq);
+   heap.pop_back();
+   if (i < size())
+   {
+      siftUp(i);
+      siftDown(i);
+   }
+}
+
+/**************************************
+ * LOT HEAP :: VALUE
+ ***************************************/
+template <class Before>
+long long LotHeap <Before> :: value() const
+{
+   long long total = 0;
+   for (int i = 0; i < size(); i++)
+      total += (long long)heap[i].shares * heap[i].price.getCents();
+   return total;
+}
+
+/**************************************
+ * LOT HEAP :: SWAP AT
+ * Swap two lots, keeping the index up to date
+ ***************************************/
+template <class Before>
+void LotHeap <Before> :: swapAt(int i, int j)
+{
+   Lot temp = heap[i];
+   heap[i] = heap[j];
+   heap[j] = temp;
+   where[heap[i].seq] = i;
+   where[heap[j].seq] = j;
+}
+
+/**************************************
+ * LOT HEAP :: SIFT UP
+ ***************************************/
+template <class Before>
+void LotHeap <Before> :: siftUp(int i)
+{
+   Before before;
+   while (i > 0 && before(heap[i], heap[(i - 1) / 2]))
+   {
+      swapAt(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+   }
+}
+
+/**************************************
+ * LOT HEAP :: SIFT DOWN
+ ***************************************/
+template <class Before>
+void LotHeap <Before> :: siftDown(int i)
+{
+   Before before;
+   for (;;)
+   {
+      int first = i;
+      int left  = i * 2 + 1;
+      int right = i * 2 + 2;
+      if (left < size() && before(heap[left], heap[first]))
+         first = left;
+      if (right < size() && before(heap[right], heap[first]))
+         first = right;
+      if (first == i)
+         return;
+      swapAt(i, first);
+      i = first;
+   }
+}
+
+/************************************************
+ * LOT BOOK
+ * Only the specializations below exist. Each one has:
+ *    push(lot)   : we bought a lot
+ *    next()      : the lot the next sale draws from
+ *    take(n)     : sell n shares of next()
+ *    empty(), size(), and value() in cents
+ ***********************************************/
+template <class Strategy>
+class LotBook;
+
+/************************************************
+ * LOT BOOK : FIFO
+ * Exactly the LotQueue, sold from the front
+ ***********************************************/
+template <>
+class LotBook <Fifo>
+{
+public:
+   void push(const Lot & lot)  { lots.push(lot);        }
+   Lot next() const            { return lots.front();   }
+   void take(int number)       { lots.takeFront(number);}
+   bool empty() const          { return lots.empty();   }
+   int size() const            { return lots.size();    }
+   long long value() const     { return lots.value();   }
+
+private:
+   LotQueue lots;
+};
+
+/************************************************
+ * LOT BOOK : LIFO
+ * The same ring, sold from the back
+ ***********************************************/
+template <>
+class LotBook <Lifo>
+{
+public:
+   void push(const Lot & lot)  { lots.push(lot);        }
+   Lot next() const            { return lots.back();    }
+   void take(int number)       { lots.takeBack(number); }
+   bool empty() const          { return lots.empty();   }
+   int size() const            { return lots.size();    }
+   long long value() const     { return lots.value();   }
+
+private:
+   LotQueue lots;
+};
+
+/************************************************
+ * LOT BOOK : HIFO
+ * Highest price first, from a heap rather than a
+ * scan of every lot for the most expensive one
+ ***********************************************/
+template <>
+class LotBook <Hifo>
+{
+public:
+   void push(const Lot & lot)  { lots.push(lot);                   }
+   Lot next() const            { return lots.top();                }
+   void take(int number)       { lots.take(lots.top().seq, number);}
+   bool empty() const          { return lots.empty();              }
+   int size() const            { return lots.size();               }
+   long long value() const     { return lots.value();              }
+
+private:
+   LotHeap <HigherPrice> lots;
+};
+
+/************************************************
+ * LOT BOOK : SPECIFIC LOT
+ * The seller names the lot. When they do not, the
+ * oldest lot goes first
+ ***********************************************/
+template <>
+class LotBook <SpecificLot>
+{
+public:
+   void push(const Lot & lot)  { lots.push(lot);                   }
+   Lot next() const            { return lots.top();                }
+   void take(int number)       { lots.take(lots.top().seq, number);}
+   bool empty() const          { return lots.empty();              }
+   int size() const            { return lots.size();               }
+   long long value() const     { return lots.value();              }
+
+   // the named lot
+   bool contains(int seq) const      { return lots.contains(seq);  }
+   Lot find(int seq) const           { return lots.find(seq);      }
+   void take(int seq, int number)    { lots.take(seq, number);     }
+
+private:
+   LotHeap <OlderLot> lots;
+};
+
+/************************************************
+ * LOT BOOK : SHARED FIFO
+ * The same order as Fifo. Copies share the lots until
+ * one of them sells or buys, and then only the segment
+ * of lots that changed is copied
+ ***********************************************/
+template <>
+class LotBook <SharedFifo>
+{
+public:
+   // a lot at the same price as the newest one joins it, as in LotQueue
+   void push(const Lot & lot)
+   {
+      const CowQueue <Lot> & read = lots;
+      if (!read.empty() && read.back().price == lot.price &&
+          read.back().shares <= INT_MAX - lot.shares)
+         lots.back().shares += lot.shares;
+      else
+         lots.push(lot);
+   }
+
+   Lot next() const            { return lots.front();   }
+   bool empty() const          { return lots.empty();   }
+   int size() const            { return lots.size();    }
+
+   // sell part of the front lot, removing it once it is used up
+   void take(int number)
+   {
+      int left = next().shares - number;
+      assert(number > 0 && left >= 0);
+      if (left == 0)
+         lots.pop();
+      else
+         lots.front().shares = left;
+   }
+
+   // the sum of shares times price, in cents
+   long long value() const
+   {
+      long long total = 0;
+      for (int i = 0; i < lots.size(); i++)
+         total += (long long)lots[i].shares * lots[i].price.getCents();
+      return total;
+   }
+
+private:
+   CowQueue <Lot> lots;
+};
+
+/************************************************
+ * SELL LOTS
+ * Sell up to "shares" in the order the book keeps its
+ * lots. "fill" is called with each lot as it was before
+ * the sale and how many of its shares were sold.
+ * Returns how many shares were sold
+ ***********************************************/
+template <class Strategy, class Fill>
+int sellLots(LotBook <Strategy> & book, int shares, Fill fill)
+{
+   assert(shares > 0);
+   int sold = 0;
+   while (sold < shares && !book.empty())
+   {
+      Lot lot = book.next();
+      int take = (lot.shares < shares - sold ? lot.shares : shares - sold);
+      fill(lot, take);
+      book.take(take);
+      sold += take;
+   }
+   return sold;
+}
+
+/************************************************
+ * SELL LOT
+ * Sell from one named lot. Returns how many shares were
+ * sold, which is none if there is no such lot
+ ***********************************************/
+template <class Fill>
+int sellLot(LotBook <SpecificLot> & book, int seq, int shares, Fill fill)
+{
+   assert(shares > 0);
+   if (!book.contains(seq))
+      return 0;
+
+   Lot lot = book.find(seq);
+   int take = (lot.shares < shares ? lot.shares : shares);
+   fill(lot, take);
+   book.take(seq, take);
+   return take;
+}
+
+#endif // LOT_BOOK_H
@@ -0,0 +1,475 @@
+/***********************************************************************
+* Header:
+*    LOT QUEUE
+* Summary:
+*    A Queue of lots stored as a structure of arrays: the shares, the
+*    prices, and the sequence ids each live in their own circular array
+*    and all three share a single head and tail. Code that only needs
+*    shares and prices, such as valuing the holdings, walks two tightly
+*    packed arrays of int instead of striding over whole lots.
+*
+*    A lot bought at the same price as the newest lot is added to that
+*    lot rather than taking an entry of its own. Either way its shares
+*    are sold in the same place in line for the same cost, so buying
+*    the same stock at the same price over and over does not grow the
+*    queue.
+*
+*    This will contain the class definition of:
+*        Lot              : a block of shares bought at one price
+*        LotQueue         : a Queue of lots, one array per field
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef LOT_QUEUE_H
+#define LOT_QUEUE_H
+
+#include <cassert>
+#include <climits>     // for INT_MAX
+#include <new>         // for BAD_ALLOC
+#include "dollars.h"   // for DOLLARS
+
+/******************************************
+ * LOT
+ * A block of shares bought at one price. The sequence
+ * id is the number of the buy that created the lot
+ ******************************************/
+struct Lot
+{
+   Lot() : shares(0), price(), seq(0) {}
+   Lot(int shares, const Dollars & price, int seq) :
+      shares(shares), price(price), seq(seq) {}
+
+   int     shares;     // how many shares are left in the lot
+   Dollars price;      // what we paid for each share
+   int     seq;        // which buy created this lot
+};
+
+/************************************************
+ * LOT QUEUE
+ * A Queue of lots with one circular array per field
+ ***********************************************/
+class LotQueue
+{
+public:
+   // default constructor : empty and kinda useless
+   LotQueue() : shares(NULL), cents(NULL), seqs(NULL), vCapacity(0),
+                countIn(0), countOut(0) {}
+
+   // copy constructor : copy it
+   LotQueue(const LotQueue & rhs);
+
+   // non-default constructor : pre-allocate
+   LotQueue(int vCapacity);
+
+   // destructor : free everything
+   ~LotQueue()          { release();                          }
+
+   // is the container currently empty
+   bool empty() const noexcept   { return size() == 0;        }
+
+   // remove all the items from the container
+   void clear() noexcept         { countIn = 0; countOut = 0; }
+
+   // how many items are currently in the container?
+   int size() const noexcept     { return countIn - countOut; }
+   int capacity() const noexcept { return vCapacity;          }
+
+   // get the lot at the front or the back of the Queue
+   Lot front() const;
+   Lot back() const;
+
+   // add a lot to the back of the Queue, or to the back lot if it
+   // has the same price. The back lot keeps its sequence id. Returns
+   // true if it joined the back lot rather than taking an entry
+   bool push(const Lot & lot);
+
+   // remove the lot at the front of the Queue
+   void pop();
+
+   // sell part of the front lot, removing it once it is used up
+   void takeFront(int number);
+
+   // the same for the back lot, for selling last-in first-out
+   void takeBack(int number);
+
+   // what the lots cost in cents: the sum of shares times price. It is
+   // a long long because a big enough holding overflows int cents
+   long long value() const;
+
+   // how many lots from the front it takes to fill an order
+   int lotsToFill(int number) const;
+
+   // what compact() did: how many lots were merged into the lot
+   // before them, and how many entries of the arrays were given back
+   struct Compacted
+   {
+      int merged;
+      int freed;
+   };
+
+   // move the lots to the start of arrays just big enough for them,
+   // merging any neighbors with the same price. push() already joins
+   // those, so the only ones left are lots that were too big to join
+   // when they were pushed and have since been sold down
+   Compacted compact();
+
+   // overloaded assignment operator
+   LotQueue & operator = (const LotQueue & rhs);
+
+private:
+   // grow the arrays when they are full
+   void resize();
+
+   // allocate all three arrays at "vCapacity", or none of them
+   void allocate(int vCapacity);
+
+   // free all three arrays
+   void release();
+
+   // trade arrays and counts with another LotQueue
+   void swap(LotQueue & rhs) noexcept;
+
+   int locHead() const noexcept
+      { return vCapacity ? countOut % vCapacity : 0; }
+   int locTail() const noexcept
+      { return vCapacity ? countIn  % vCapacity : 0; }
+
+   // take a whole lap off both counts once the head has gone around,
+   // as Queue does, so they stay small however long the ring runs
+   void rebase() noexcept
+   {
+      if (countOut >= vCapacity)
+      {
+         countOut -= vCapacity;
+         countIn -= vCapacity;
+      }
+   }
+
+   int * shares;      // the shares of each lot
+   int * cents;       // the price of each lot
+   int * seqs;        // the sequence id of each lot
+   int vCapacity;     // how many lots fit before we need to grow
+   int countIn;       // the number of lots added to queue
+   int countOut;      // the number of lots removed from queue
+};
+
+/*******************************************
+ * LOT QUEUE :: ALLOCATE
+ * Get three arrays of the same size
+ *******************************************/
+inline void LotQueue :: allocate(int vCapacity)
+{
+   try
+   {
+      shares = cents = seqs = NULL;
+      shares = new int[vCapacity];
+      cents  = new int[vCapacity];
+      seqs   = new int[vCapacity];
+   }
+   catch (std::bad_alloc)
+   {
+      release();
+      throw "ERROR: Unable to allocate buffer";
+   }
+   this->vCapacity = vCapacity;
+}
+
+/*******************************************
+ * LOT QUEUE :: RELEASE
+ * Free the arrays. Deleting NULL does nothing
+ *******************************************/
+inline void LotQueue :: release()
+{
+   delete [] shares;
+   delete [] cents;
+   delete [] seqs;
+   shares = cents = seqs = NULL;
+   vCapacity = 0;
+}
+
+/*******************************************
+ * LOT QUEUE :: COPY CONSTRUCTOR
+ *******************************************/
+inline LotQueue :: LotQueue(const LotQueue & rhs) :
+   shares(NULL), cents(NULL), seqs(NULL), vCapacity(0),
+   countIn(0), countOut(0)
+{
+   *this = rhs;
+}
+
+/**********************************************
+ * LOT QUEUE : NON-DEFAULT CONSTRUCTOR
+ * Preallocate the arrays to "capacity"
+ **********************************************/
+inline LotQueue :: LotQueue(int vCapacity) :
+   shares(NULL), cents(NULL), seqs(NULL), vCapacity(0),
+   countIn(0), countOut(0)
+{
+   assert(vCapacity >= 0);
+   if (vCapacity)
+      allocate(vCapacity);
+}
+
+/**********************************************
+ * LOT QUEUE :: ASSIGNMENT
+ * Copy the lots over, lining them up at the start
+ * of the arrays
+ **********************************************/
+inline LotQueue & LotQueue :: operator = (const LotQueue & rhs)
+{
+   if (this == &rhs)
+      return *this;
+
+   // build the copy on the side, so a failed allocation leaves this
+   // queue as it was
+   LotQueue temp;
+   if (rhs.vCapacity)
+      temp.allocate(rhs.vCapacity);
+   for (int i = 0, x = rhs.locHead(); i < rhs.size(); i++, x++)
+   {
+      if (x == rhs.vCapacity)
+         x = 0;
+      temp.shares[i] = rhs.shares[x];
+      temp.cents[i]  = rhs.cents[x];
+      temp.seqs[i]   = rhs.seqs[x];
+   }
+   temp.countIn = rhs.size();
+   swap(temp);
+   return *this;
+}
+
+/**************************************
+ * LOT QUEUE :: FRONT
+ * Gather the lot at the head from the three arrays
+ ***************************************/
+inline Lot LotQueue :: front() const
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   int i = locHead();
+   return Lot(shares[i], Dollars(cents[i]), seqs[i]);
+}
+
+/**************************************
+ * LOT QUEUE :: BACK
+ * Gather the lot just before the tail
+ ***************************************/
+inline Lot LotQueue :: back() const
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   int i = (countIn - 1) % vCapacity;
+   return Lot(shares[i], Dollars(cents[i]), seqs[i]);
+}
+
+/**************************************
+ * LOT QUEUE :: PUSH
+ * Scatter the lot into the three arrays at the tail,
+ * unless it can join the lot already there
+ ***************************************/
+inline bool LotQueue :: push(const Lot & lot)
+{
+   if (!empty())
+   {
+      int i = (countIn - 1) % vCapacity;
+      if (cents[i] == lot.price.getCents() &&
+          shares[i] <= INT_MAX - lot.shares)
+      {
+         shares[i] += lot.shares;
+         return true;
+      }
+   }
+
+   resize();
+   int i = locTail();
+   shares[i] = lot.shares;
+   cents[i]  = lot.price.getCents();
+   seqs[i]   = lot.seq;
+   countIn++;
+   return false;
+}
+
+/**************************************
+ * LOT QUEUE :: POP
+ * Move the head forward one lot
+ ***************************************/
+inline void LotQueue :: pop()
+{
+   if (empty())
+      throw "ERROR: attempting to pop from an empty queue";
+   countOut++;
+   rebase();
+}
+
+/**************************************
+ * LOT QUEUE :: TAKE FRONT
+ * A partial fill only touches the shares array
+ ***************************************/
+inline void LotQueue :: takeFront(int number)
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   int i = locHead();
+   assert(number > 0 && number <= shares[i]);
+   shares[i] -= number;
+   if (shares[i] == 0)
+   {
+      countOut++;
+      rebase();
+   }
+}
+
+/**************************************
+ * LOT QUEUE :: TAKE BACK
+ * Like takeFront() but from the tail, so the ring
+ * also works as a stack of lots
+ ***************************************/
+inline void LotQueue :: takeBack(int number)
+{
+   if (empty())
+      throw "ERROR: attempting to access an item in an empty queue";
+   int i = (countIn - 1) % vCapacity;
+   assert(number > 0 && number <= shares[i]);
+   shares[i] -= number;
+   if (shares[i] == 0)
+      countIn--;
+}
+
+/**************************************
+ * LOT QUEUE :: VALUE
+ * The ring is at most two runs of contiguous memory:
+ * head to the end of the arrays, then the start of the
+ * arrays to the tail. Each run is a plain loop over two
+ * int arrays the compiler can vectorize
+ ***************************************/
+inline long long LotQueue :: value() const
+{
+   long long total = 0;
+   int head = locHead();
+   int firstRun = (head + size() <= vCapacity) ? size() : vCapacity - head;
+
+   const int * s = shares + head;
+   const int * c = cents + head;
+   for (int i = 0; i < firstRun; i++)
+      total += (long long)s[i] * c[i];
+
+   for (int i = 0; i < size() - firstRun; i++)
+      total += (long long)shares[i] * cents[i];
+
+   return total;
+}
+
+/**************************************
+ * LOT QUEUE :: LOTS TO FILL
+ * Walk the shares array from the head until we have
+ * enough. Returns size() + 1 if all the lots are not enough.
+ * The walk is split into the same two contiguous runs
+ * value() uses, so neither loop checks for the wrap. Each
+ * one still stops as soon as the order is filled, which
+ * keeps it from vectorizing, but it is a plain scan of one
+ * int array
+ ***************************************/
+inline int LotQueue :: lotsToFill(int number) const
+{
+   int head = locHead();
+   int firstRun = (head + size() <= vCapacity) ? size() : vCapacity - head;
+
+   const int * s = shares + head;
+   for (int i = 0; i < firstRun; i++)
+   {
+      number -= s[i];
+      if (number <= 0)
+         return i + 1;
+   }
+
+   for (int i = 0; i < size() - firstRun; i++)
+   {
+      number -= shares[i];
+      if (number <= 0)
+         return firstRun + i + 1;
+   }
+   return size() + 1;
+}
+
+/**************************************
+ * LOT QUEUE :: RESIZE
+ * Double the arrays, unwrapping the ring as we go
+ ***************************************/
+inline void LotQueue :: resize()
+{
+   if (vCapacity != 0 && size() < vCapacity)
+      return;
+
+   LotQueue temp;
+   temp.allocate(vCapacity ? vCapacity * 2 : 1);
+   for (int i = 0, x = locHead(); i < size(); i++, x++)
+   {
+      if (x == vCapacity)
+         x = 0;
+      temp.shares[i] = shares[x];
+      temp.cents[i]  = cents[x];
+      temp.seqs[i]   = seqs[x];
+   }
+   temp.countIn = size();
+
+   // take over the new arrays and let temp free the old ones
+   swap(temp);
+}
+
+/**************************************
+ * LOT QUEUE :: COMPACT
+ * Push every lot into a fresh queue, which merges the
+ * neighbors, then copy what is left into arrays that fit.
+ * A queue that was doubled to hold a burst of lots gets
+ * the space back. Neighbors at one price are only apart
+ * when their shares added up past INT_MAX; once the
+ * front one has been sold down they fit in one lot
+ ***************************************/
+inline LotQueue::Compacted LotQueue :: compact()
+{
+   Compacted done;
+   done.freed = vCapacity;
+   done.merged = 0;
+
+   LotQueue merged;
+   if (!empty())
+      merged.allocate(size());
+   for (int i = 0, x = locHead(); i < size(); i++, x++)
+   {
+      if (x == vCapacity)
+         x = 0;
+      done.merged += merged.push(Lot(shares[x], Dollars(cents[x]), seqs[x]));
+   }
+
+   LotQueue temp;
+   if (!merged.empty())
+      temp.allocate(merged.size());
+   for (int i = 0; i < merged.size(); i++)
+   {
+      temp.shares[i] = merged.shares[i];
+      temp.cents[i]  = merged.cents[i];
+      temp.seqs[i]   = merged.seqs[i];
+   }
+   temp.countIn = merged.size();
+
+   swap(temp);
+   done.freed -= vCapacity;
+   return done;
+}
+
+/**************************************
+ * LOT QUEUE :: SWAP
+ ***************************************/
+inline void LotQueue :: swap(LotQueue & rhs) noexcept
+{
+   int * s = shares;  shares = rhs.shares;  rhs.shares = s;
+   int * c = cents;   cents  = rhs.cents;   rhs.cents  = c;
+   int * q = seqs;    seqs   = rhs.seqs;    rhs.seqs   = q;
+   int v = vCapacity; vCapacity = rhs.vCapacity; rhs.vCapacity = v;
+   int i = countIn;   countIn = rhs.countIn;     rhs.countIn = i;
+   int o = countOut;  countOut = rhs.countOut;   rhs.countOut = o;
+}
+
+#endif // LOT_QUEUE_H
@@ -0,0 +1,161 @@
+/***********************************************************************
+ * Header:
+ *    MAP BOOK
+ * Summary:
+ *    A limit order book built the usual way, as the reference the flat
+ *    OrderBook is checked and timed against: the price levels are a
+ *    std::map and the orders at each level a std::list. The matching
+ *    rules are the same, so the same orders must give the same fills.
+ *    Its ids are simply the orders in the order they were added.
+ *
+ *    This will contain the class definition of:
+ *        MapBook          : a std::map of price levels
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef MAP_BOOK_H
+#define MAP_BOOK_H
+
+#include <vector>        // for VECTOR
+#include <map>           // for MAP
+#include <list>          // for LIST
+#include "orderBook.h"   // for ORDER and FILL
+
+/******************************************
+ * MAP BOOK
+ * Prices are in cents
+ ******************************************/
+class MapBook
+{
+public:
+   MapBook() : nextId(0), live(0) {}
+
+   // match an order, resting what is left. Returns the order's id
+   int add(Order::Side side, int shares, int cents, std::vector <Fill> & fills)
+   {
+      int id = nextId++;
+      where.push_back(Entry());
+
+      if (side == Order::BUY)
+         while (shares > 0 && !asks.empty() && asks.begin()->first <= cents)
+            shares = take(asks, asks.begin(), id, shares, fills);
+      else
+         while (shares > 0 && !bids.empty() && bids.rbegin()->first >= cents)
+            shares = take(bids, --bids.end(), id, shares, fills);
+
+      if (shares == 0)
+         return id;
+      Levels & levels = (side == Order::BUY ? bids : asks);
+      std::list <Resting> & level = levels[cents];
+      level.push_back(Resting(id, shares));
+      where[id].live   = true;
+      where[id].side   = side;
+      where[id].cents  = cents;
+      where[id].it     = --level.end();
+      live++;
+      return id;
+   }
+
+   // take a resting order out. False if it is not there
+   bool cancel(int id)
+   {
+      if (id < 0 || id >= (int)where.size() || !where[id].live)
+         return false;
+      Levels & levels = (where[id].side == Order::BUY ? bids : asks);
+      Levels::iterator level = levels.find(where[id].cents);
+      level->second.erase(where[id].it);
+      if (level->second.empty())
+         levels.erase(level);
+      where[id].live = false;
+      live--;
+      return true;
+   }
+
+   // how many shares of an order are still resting
+   int remaining(int id) const
+   {
+      if (id < 0 || id >= (int)where.size() || !where[id].live)
+         return 0;
+      return where[id].it->shares;
+   }
+
+   // the best prices, false if that side is empty
+   bool bestBid(int & cents) const
+   {
+      if (bids.empty())
+         return false;
+      cents = bids.rbegin()->first;
+      return true;
+   }
+   bool bestAsk(int & cents) const
+   {
+      if (asks.empty())
+         return false;
+      cents = asks.begin()->first;
+      return true;
+   }
+
+   // how many shares rest at a price on one side
+   int depth(Order::Side side, int cents) const
+   {
+      const Levels & levels = (side == Order::BUY ? bids : asks);
+      Levels::const_iterator level = levels.find(cents);
+      int shares = 0;
+      if (level != levels.end())
+         for (const Resting & resting : level->second)
+            shares += resting.shares;
+      return shares;
+   }
+
+   // how many orders are resting
+   int size() const { return live; }
+
+private:
+   struct Resting
+   {
+      Resting(int id, int shares) : id(id), shares(shares) {}
+      int id;
+      int shares;
+   };
+   typedef std::map <int, std::list <Resting> > Levels;
+   struct Entry
+   {
+      Entry() : live(false), side(Order::BUY), cents(0) {}
+      bool live;
+      Order::Side side;
+      int cents;
+      std::list <Resting> ::iterator it;
+   };
+
+   int take(Levels & levels, Levels::iterator level, int id, int shares,
+            std::vector <Fill> & fills)
+   {
+      std::list <Resting> & orders = level->second;
+      while (shares > 0 && !orders.empty())
+      {
+         Resting & resting = orders.front();
+         int amount = resting.shares < shares ? resting.shares : shares;
+         fills.push_back(Fill(resting.id, id, amount, Dollars(level->first)));
+         resting.shares -= amount;
+         shares -= amount;
+         if (resting.shares == 0)
+         {
+            where[resting.id].live = false;
+            orders.pop_front();
+            live--;
+         }
+      }
+      if (orders.empty())
+         levels.erase(level);
+      return shares;
+   }
+
+   Levels bids;
+   Levels asks;
+   std::vector <Entry> where;
+   int nextId;
+   int live;
+};
+
+#endif // MAP_BOOK_H
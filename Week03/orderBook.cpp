@@ -0,0 +1,293 @@
+/***********************************************************************
+ * Implementation:
+ *    ORDER BOOK
+ * Summary:
+ *    Matching limit orders against price levels kept in a flat array
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cassert>       // for ASSERT
+#include "orderBook.h"   // for ORDER_BOOK
+using namespace std;
+
+/********************************************
+ * ORDER BOOK : NON-DEFAULT CONSTRUCTOR
+ * Every level exists from the start, empty
+ *******************************************/
+OrderBook :: OrderBook(const Dollars & reference, int tickCents, int levels) :
+   reference(reference), tickCents(tickCents), numLevels(levels),
+   topBid(-1), topAsk(levels), live(0)
+{
+   if (tickCents <= 0 || levels <= 0)
+      throw "ERROR: an order book needs a positive tick and levels";
+   bids.resize(levels);
+   asks.resize(levels);
+}
+
+/********************************************
+ * ORDER BOOK :: LEVEL OF
+ * Prices between ticks or outside the book have no level
+ *******************************************/
+int OrderBook :: levelOf(const Dollars & price) const
+{
+   int offset = price.getCents() - reference.getCents();
+   if (offset < 0 || offset % tickCents != 0)
+      return -1;
+   int level = offset / tickCents;
+   return level < numLevels ? level : -1;
+}
+
+/********************************************
+ * ORDER BOOK :: ADD
+ * Trade what crosses, then rest the remainder at the
+ * back of its level
+ *******************************************/
+int OrderBook :: add(Order::Side side, int shares, const Dollars & price,
+                     Queue <Fill> & fills)
+{
+   assert(shares > 0);
+   int level = levelOf(price);
+   if (level < 0)
+      return -1;
+
+   int id = newId();
+   int left = match(id, side, shares, level, fills);
+   if (left == 0)
+   {
+      release(id);
+      return id;
+   }
+
+   State & state = states[id & ((1 << SLOT_BITS) - 1)];
+   state.shares = left;
+   state.level  = level;
+   state.side   = side;
+   live++;
+
+   Level & rest = (side == Order::BUY ? bids[level] : asks[level]);
+   rest.orders.push(Order(id, side, left, price));
+   rest.shares += left;
+
+   if (side == Order::BUY && level > topBid)
+      topBid = level;
+   if (side == Order::SELL && level < topAsk)
+      topAsk = level;
+   return id;
+}
+
+/********************************************
+ * ORDER BOOK :: MATCH
+ * Walk the other side from its best level towards the
+ * limit, taking the oldest order at each level first.
+ * Returns how many shares are left over
+ *******************************************/
+int OrderBook :: match(int id, Order::Side side, int shares, int limit,
+                       Queue <Fill> & fills)
+{
+   for (;;)
+   {
+      // the best level on the other side, if it crosses
+      int level;
+      if (side == Order::BUY)
+      {
+         settleAsk();
+         if (topAsk >= numLevels || topAsk > limit)
+            return shares;
+         level = topAsk;
+      }
+      else
+      {
+         settleBid();
+         if (topBid < 0 || topBid < limit)
+            return shares;
+         level = topBid;
+      }
+
+      Level & other = (side == Order::BUY ? asks[level] : bids[level]);
+      while (shares > 0 && !other.orders.empty())
+      {
+         // orders that were cancelled are dropped as they reach the front
+         Order & resting = other.orders.front();
+         State * state = find(resting.id);
+         if (state == NULL)
+         {
+            other.orders.pop();
+            other.dead--;
+            continue;
+         }
+
+         int take = (state->shares < shares ? state->shares : shares);
+         fills.push(Fill(resting.id, id, take, resting.price));
+         state->shares -= take;
+         other.shares -= take;
+         shares -= take;
+
+         if (state->shares == 0)
+         {
+            release(resting.id);
+            other.orders.pop();
+            live--;
+         }
+      }
+      purge(other);
+      if (shares == 0)
+         return 0;
+   }
+}
+
+/********************************************
+ * ORDER BOOK :: CANCEL
+ * Look the order up by id and mark it as gone. The level
+ * total is fixed now; the Queue entry is dropped when
+ * the level is purged
+ *******************************************/
+bool OrderBook :: cancel(int id)
+{
+   State * state = find(id);
+   if (state == NULL)
+      return false;
+
+   Level & level = (state->side == Order::BUY ? bids[state->level]
+                                              : asks[state->level]);
+   level.shares -= state->shares;
+   level.dead++;
+   release(id);
+   live--;
+   purge(level);
+   return true;
+}
+
+/********************************************
+ * ORDER BOOK :: NEW ID
+ * Reuse a slot if there is one, else make one
+ *******************************************/
+int OrderBook :: newId()
+{
+   int slot;
+   if (!freeSlots.empty())
+   {
+      slot = freeSlots.back();
+      freeSlots.pop_back();
+   }
+   else
+   {
+      if (states.size() == (size_t)1 << SLOT_BITS)
+         throw "ERROR: too many orders are resting in the book";
+      slot = (int)states.size();
+      states.push_back(State());
+   }
+   return states[slot].uses << SLOT_BITS | slot;
+}
+
+/********************************************
+ * ORDER BOOK :: RELEASE
+ * The next order in the slot gets a new id. A slot that
+ * has had MAX_USES orders is never used again, since
+ * its next id would be one given out before
+ *******************************************/
+void OrderBook :: release(int id)
+{
+   int slot = id & ((1 << SLOT_BITS) - 1);
+   State & state = states[slot];
+   assert(state.uses == id >> SLOT_BITS);
+   state.shares = 0;
+   if (++state.uses < MAX_USES)
+      freeSlots.push_back(slot);
+}
+
+/********************************************
+ * ORDER BOOK :: PURGE
+ * A level with nothing left forgets all its entries.
+ * Otherwise the cancelled entries at the front go, and
+ * if more than half of what is left is cancelled the
+ * level is copied without them. Each copy follows at
+ * least as many cancels as it keeps orders, so it costs
+ * O(1) a cancel over time
+ *******************************************/
+void OrderBook :: purge(Level & level)
+{
+   if (level.shares == 0)
+   {
+      level.orders.clear();
+      level.dead = 0;
+      return;
+   }
+
+   while (level.dead > 0 && find(level.orders.front().id) == NULL)
+   {
+      level.orders.pop();
+      level.dead--;
+   }
+
+   if (level.dead * 2 > level.orders.size())
+   {
+      Queue <Order> kept(level.orders.size() - level.dead);
+      Order order;
+      while (level.orders.tryPop(order))
+         if (find(order.id) != NULL)
+            kept.push(order);
+      level.orders = kept;
+      level.dead = 0;
+   }
+   assert(level.dead >= 0 && level.dead < level.orders.size());
+}
+
+/********************************************
+ * ORDER BOOK :: SETTLE BID
+ * The levels are next to each other in memory so
+ * stepping over empty ones is a short linear scan
+ *******************************************/
+void OrderBook :: settleBid()
+{
+   while (topBid >= 0 && bids[topBid].shares == 0)
+      topBid--;
+}
+
+/********************************************
+ * ORDER BOOK :: SETTLE ASK
+ *******************************************/
+void OrderBook :: settleAsk()
+{
+   while (topAsk < numLevels && asks[topAsk].shares == 0)
+      topAsk++;
+}
+
+/********************************************
+ * ORDER BOOK :: BEST BID
+ *******************************************/
+bool OrderBook :: bestBid(Dollars & price) const
+{
+   for (int level = topBid; level >= 0; level--)
+      if (bids[level].shares)
+      {
+         price = priceOf(level);
+         return true;
+      }
+   return false;
+}
+
+/********************************************
+ * ORDER BOOK :: BEST ASK
+ *******************************************/
+bool OrderBook :: bestAsk(Dollars & price) const
+{
+   for (int level = topAsk; level < numLevels; level++)
+      if (asks[level].shares)
+      {
+         price = priceOf(level);
+         return true;
+      }
+   return false;
+}
+
+/********************************************
+ * ORDER BOOK :: DEPTH
+ *******************************************/
+int OrderBook :: depth(Order::Side side, const Dollars & price) const
+{
+   int level = levelOf(price);
+   if (level < 0)
+      return 0;
+   return side == Order::BUY ? bids[level].shares : asks[level].shares;
+}
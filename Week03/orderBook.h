@@ -0,0 +1,199 @@
+/***********************************************************************
+ * Header:
+ *    ORDER BOOK
+ * Summary:
+ *    A limit order book for matching incoming orders. Every price
+ *    level is a Queue of the orders resting at that price, oldest
+ *    first, so time priority is just the order of the Queue. The
+ *    levels are one flat array indexed by how many ticks a price is
+ *    from a reference price, so finding a level is arithmetic rather
+ *    than a walk down a tree of nodes.
+ *
+ *    Orders are cancelled in O(1): the order is looked up by its id
+ *    and marked as gone. Cancelled entries at the front of a level are
+ *    dropped at once, and one in the middle is dropped when it reaches
+ *    the front, or when a level that is more than half cancelled
+ *    entries is compacted, so a level never holds more than twice what
+ *    is resting in it.
+ *
+ *    An id is a slot in the book's table of orders and how many times
+ *    that slot has been used. A slot is reused once its order is done,
+ *    until it has been used MAX_USES times and is retired, so an old
+ *    id never names a newer order and the table grows with the orders
+ *    resting at once plus one slot in every MAX_USES orders, rather
+ *    than with every order ever added.
+ *
+ *    This will contain the class definition of:
+ *        Order            : one limit order
+ *        Fill             : part of an order that traded
+ *        OrderBook        : the resting orders on both sides
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include <vector>      // for VECTOR
+#include "dollars.h"   // for DOLLARS
+#include "queue.h"     // for QUEUE
+
+/******************************************
+ * ORDER
+ * A limit order as it rests in a price level
+ ******************************************/
+struct Order
+{
+   enum Side { BUY, SELL };
+
+   Order() : id(-1), side(BUY), shares(0), price() {}
+   Order(int id, Side side, int shares, const Dollars & price) :
+      id(id), side(side), shares(shares), price(price) {}
+
+   int     id;         // given out by the book
+   Side    side;
+   int     shares;     // how many shares were asked for
+   Dollars price;      // the worst price the order will trade at
+};
+
+/******************************************
+ * FILL
+ * A trade between a resting order and an incoming one
+ ******************************************/
+struct Fill
+{
+   Fill() : resting(-1), incoming(-1), shares(0), price() {}
+   Fill(int resting, int incoming, int shares, const Dollars & price) :
+      resting(resting), incoming(incoming), shares(shares), price(price) {}
+
+   int     resting;    // the id of the order that was in the book
+   int     incoming;   // the id of the order that crossed it
+   int     shares;
+   Dollars price;      // always the resting order's price
+};
+
+/******************************************
+ * ORDER BOOK
+ * Bids and asks over a fixed range of prices:
+ *    reference, reference + tick, ... reference + (levels - 1) * tick
+ ******************************************/
+class OrderBook
+{
+public:
+   // non-default constructor : the range of prices the book covers
+   OrderBook(const Dollars & reference, int tickCents, int levels);
+
+   // how many bits of an id are its slot, and how many times a slot
+   // is used before it is retired. Together they fill a positive int
+   static constexpr int SLOT_BITS = 22;
+   static constexpr int MAX_USES  = 1 << (31 - SLOT_BITS);
+
+   // match an order against the book, resting what is left.
+   // Returns the order's id, or -1 if the price is off the book.
+   // Throws if 2 to the SLOT_BITS orders are already resting
+   int add(Order::Side side, int shares, const Dollars & price,
+           Queue <Fill> & fills);
+
+   // take a resting order out of the book. False if it is not there
+   bool cancel(int id);
+
+   // how many shares of an order are still resting
+   int remaining(int id) const
+   {
+      const State * state = find(id);
+      return state ? state->shares : 0;
+   }
+
+   // the best prices, false if that side is empty
+   bool bestBid(Dollars & price) const;
+   bool bestAsk(Dollars & price) const;
+
+   // how many shares rest at a price on one side
+   int depth(Order::Side side, const Dollars & price) const;
+
+   // how many orders are resting
+   int size() const { return live; }
+
+   // how many slots for orders the book has made
+   int slots() const { return (int)states.size(); }
+
+private:
+   /******************************************
+    * LEVEL
+    * The orders at one price, oldest first, and
+    * the shares they have left between them
+    ******************************************/
+   struct Level
+   {
+      Level() : shares(0), dead(0) {}
+      Queue <Order> orders;
+      int shares;
+      int dead;           // cancelled entries still in "orders"
+   };
+
+   /******************************************
+    * STATE
+    * What the book knows about an order by its id
+    ******************************************/
+   struct State
+   {
+      State() : shares(0), level(-1), side(Order::BUY), uses(0) {}
+      int shares;         // left to trade, 0 once filled or cancelled
+      int level;          // which level it rests on
+      Order::Side side;
+      int uses;           // how many orders have had this slot before
+   };
+
+   // the state of the order with this id, or NULL if it is done
+   const State * find(int id) const
+   {
+      int slot = id & ((1 << SLOT_BITS) - 1);
+      if (id < 0 || slot >= (int)states.size())
+         return NULL;
+      const State & state = states[slot];
+      return (id >> SLOT_BITS) == state.uses && state.shares > 0 ?
+             &state : NULL;
+   }
+   State * find(int id)
+   {
+      return const_cast <State *> (((const OrderBook *)this)->find(id));
+   }
+
+   // a slot for a new order and the id that names it
+   int newId();
+
+   // the order with this id is done; its slot can be used again
+   void release(int id);
+
+   // drop the cancelled entries at the front of a level, and all of
+   // them if they are more than half of it
+   void purge(Level & level);
+
+   // the level for a price, or -1 if it is not on a tick in range
+   int levelOf(const Dollars & price) const;
+   Dollars priceOf(int level) const
+   {
+      return Dollars(reference.getCents() + level * tickCents);
+   }
+
+   // trade against the other side as far as the limit allows
+   int match(int id, Order::Side side, int shares, int limit,
+             Queue <Fill> & fills);
+
+   // move the best bid down or the best ask up past empty levels
+   void settleBid();
+   void settleAsk();
+
+   Dollars reference;            // the price of level 0
+   int tickCents;                // the price step between levels
+   int numLevels;                // how many levels on each side
+   std::vector <Level> bids;     // the buy orders by level
+   std::vector <Level> asks;     // the sell orders by level
+   std::vector <State> states;   // the orders by slot
+   std::vector <int> freeSlots;  // slots that can be used again
+   int topBid;                   // highest level with bids, -1 if none
+   int topAsk;                   // lowest level with asks, numLevels if none
+   int live;                     // orders with shares still resting
+};
+
+#endif // ORDER_BOOK_H
@@ -0,0 +1,172 @@
+/***********************************************************************
+ * Program:
+ *    ORDER BOOK BENCH
+ * Summary:
+ *    Replays a stream of random limit orders and cancels through the
+ *    flat OrderBook and through a book built the usual way, from a
+ *    std::map of price levels, and reports how fast each one was. The
+ *    fills from the two books must be identical. queueTest checks the
+ *    matching much more closely; this is a last check on the replay.
+ *
+ *        orderBookBench [messages] [seed]
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#include <iostream>      // for COUT
+#include <vector>        // for VECTOR
+#include <random>        // for MT19937
+#include <chrono>        // for STEADY_CLOCK
+#include <cstdlib>       // for ATOL
+#include <unordered_map> // for UNORDERED_MAP
+#include "orderBook.h"   // for ORDER_BOOK
+#include "mapBook.h"     // for MAP_BOOK
+using namespace std;
+
+// the prices the replay moves between
+const int REFERENCE_CENTS = 10000;
+const int NUM_LEVELS      = 2000;
+
+/*******************************************
+ * MESSAGE
+ * One line of the replay: an order or a cancel
+ *******************************************/
+struct Message
+{
+   bool cancel;
+   int  id;            // the order to cancel
+   Order::Side side;
+   int  shares;
+   int  cents;
+};
+
+/*******************************************
+ * MAKE REPLAY
+ * Orders around a price that wanders, with cancels
+ * of recent orders mixed in
+ *******************************************/
+vector <Message> makeReplay(long count, unsigned int seed)
+{
+   mt19937 random(seed);
+   vector <Message> replay(count);
+   int mid = NUM_LEVELS / 2;
+   int orders = 0;
+
+   for (long i = 0; i < count; i++)
+   {
+      Message & message = replay[i];
+      message.cancel = (orders > 0 && random() % 100 < 30);
+      if (message.cancel)
+      {
+         int recent = orders < 1000 ? orders : 1000;
+         message.id = orders - 1 - (int)(random() % recent);
+         continue;
+      }
+
+      if (random() % 10 == 0)
+         mid += (int)(random() % 3) - 1;
+      if (mid < 100)              mid = 100;
+      if (mid > NUM_LEVELS - 100) mid = NUM_LEVELS - 100;
+
+      message.side = (random() % 2 ? Order::BUY : Order::SELL);
+      message.shares = (int)(random() % 500) + 1;
+      int offset = (int)(random() % 20) - 5;
+      int level = (message.side == Order::BUY ? mid - offset : mid + offset);
+      message.cents = REFERENCE_CENTS + level;
+      orders++;
+   }
+   return replay;
+}
+
+/*******************************************
+ * SECONDS SINCE
+ *******************************************/
+double secondsSince(const chrono::steady_clock::time_point & start)
+{
+   return chrono::duration <double> (chrono::steady_clock::now() - start)
+      .count();
+}
+
+/*******************************************
+ * REPORT
+ * One line of results for one book
+ *******************************************/
+void report(const char * name, long messages, double seconds, long fills)
+{
+   cout << name << "\t" << messages / seconds / 1e6 << " M messages/s\t"
+        << seconds * 1e9 / messages << " ns/message\t"
+        << fills << " fills\n";
+}
+
+/**********************************************************************
+ * MAIN
+ * Replay through both books, compare, and time them
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   long count = (argc > 1 ? atol(argv[1]) : 2000000);
+   unsigned int seed = (argc > 2 ? atoi(argv[2]) : 1);
+   vector <Message> replay = makeReplay(count, seed);
+
+   // the flat book. Fills are drained after every message. Its ids
+   // are not the order numbers the replay cancels by, so it keeps them
+   OrderBook book(Dollars(REFERENCE_CENTS), 1, NUM_LEVELS);
+   Queue <Fill> fills;
+   vector <Fill> flatFills;
+   vector <int> ids;
+   flatFills.reserve(count);
+   ids.reserve(count);
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (long i = 0; i < count; i++)
+   {
+      const Message & message = replay[i];
+      if (message.cancel)
+         book.cancel(ids[message.id]);
+      else
+         ids.push_back(book.add(message.side, message.shares,
+                                Dollars(message.cents), fills));
+      for (; !fills.empty(); fills.pop())
+         flatFills.push_back(fills.front());
+      fills.clear();
+   }
+   double flatSeconds = secondsSince(start);
+
+   // an id is never given out twice, so it names one order number
+   unordered_map <int, int> numbers;
+   for (size_t i = 0; i < ids.size(); i++)
+      numbers[ids[i]] = (int)i;
+   for (size_t i = 0; i < flatFills.size(); i++)
+   {
+      flatFills[i].resting  = numbers[flatFills[i].resting];
+      flatFills[i].incoming = numbers[flatFills[i].incoming];
+   }
+
+   // the map book
+   MapBook mapBook;
+   vector <Fill> mapFills;
+   mapFills.reserve(count);
+   start = chrono::steady_clock::now();
+   for (long i = 0; i < count; i++)
+   {
+      const Message & message = replay[i];
+      if (message.cancel)
+         mapBook.cancel(message.id);
+      else
+         mapBook.add(message.side, message.shares, message.cents, mapFills);
+   }
+   double mapSeconds = secondsSince(start);
+
+   // the two books must have traded exactly the same way
+   bool same = (flatFills.size() == mapFills.size());
+   for (size_t i = 0; same && i < flatFills.size(); i++)
+      same = flatFills[i].resting  == mapFills[i].resting  &&
+             flatFills[i].incoming == mapFills[i].incoming &&
+             flatFills[i].shares   == mapFills[i].shares   &&
+             flatFills[i].price    == mapFills[i].price;
+
+   report("OrderBook", count, flatSeconds, (long)flatFills.size());
+   report("std::map ", count, mapSeconds,  (long)mapFills.size());
+   cout << "speedup " << mapSeconds / flatSeconds << "x, fills "
+        << (same ? "match\n" : "DIFFER\n");
+   return same ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+/***********************************************************************
+ * Implementation:
+ *    PIPELINE
+ * Summary:
+ *    The stock program split into parse, match, and report stages.
+ *    Each stage runs on its own thread, pinned to its own core when
+ *    there are enough of them, and passes batches down the line
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <iostream>    // for ISTREAM and OSTREAM
+#include <string>      // for STRING and GETLINE
+#include <thread>      // for THREAD
+#include <chrono>      // for STEADY_CLOCK
+#include <pthread.h>   // for PTHREAD_SETAFFINITY_NP
+#include <sched.h>     // for CPU_SET
+#include "pipeline.h"  // for BOUNDED_QUEUE
+#include "stock.h"     // for PORTFOLIO, COMMAND, and EVENT
+using namespace std;
+
+// how many items move between stages at once
+const int BATCH_SIZE = 64;
+
+// how many items may be waiting between two stages
+const int RING_SIZE = 1024;
+
+// the longest the parse stage holds on to a batch that is not full
+const chrono::microseconds MAX_HOLD(500);
+
+/********************************************
+ * SECONDS SINCE
+ * Elapsed time from "start" until now
+ *******************************************/
+static double secondsSince(const chrono::steady_clock::time_point & start)
+{
+   return chrono::duration <double> (chrono::steady_clock::now() - start)
+      .count();
+}
+
+/********************************************
+ * PIN TO CORE
+ * Keep the calling thread on one core so the stages do not
+ * fight over a core. Returns the core or -1 if there are not
+ * enough cores to go around
+ *******************************************/
+static int pinToCore(int stage)
+{
+   unsigned int cores = thread::hardware_concurrency();
+   if (cores < PipelineStats::NUM_STAGES)
+      return -1;
+
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(stage, &set);
+   if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+      return -1;
+   return stage;
+}
+
+/********************************************
+ * PARSE STAGE
+ * Read lines and tokenize them into commands. A batch is
+ * handed on when it is full, when it has been held for
+ * MAX_HOLD, or when reading more might block, so an
+ * interactive user still sees each command answered.
+ * Whether a read might block is only known to a stream
+ * with a buffer of its own; cin synced with stdio always
+ * says it might, so the driver turns that off. Time spent
+ * in getline() is reading, not parsing, so it is not busy
+ *******************************************/
+static void parseStage(istream & in, BoundedQueue <Command> & commands,
+                       StageStats & stats)
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   stats.core = pinToCore(PipelineStats::PARSE);
+   double waiting = 0.0;
+
+   Queue <Command> batch(BATCH_SIZE);
+   chrono::steady_clock::time_point held = start;
+   string line;
+   bool done = false;
+   while (!done)
+   {
+      // blank lines are not commands
+      chrono::steady_clock::time_point read = chrono::steady_clock::now();
+      bool more = (bool)getline(in, line);
+      chrono::steady_clock::time_point parse = chrono::steady_clock::now();
+      waiting += chrono::duration <double> (parse - read).count();
+
+      Command command;
+      bool blank = false;
+      if (!more)
+         command.type = Command::QUIT;
+      else if (line.find_first_not_of(" \t\r") == string::npos)
+         blank = true;
+      else
+         command = parseCommand(line);
+      done = (command.type == Command::QUIT);
+
+      if (!blank)
+      {
+         if (batch.empty())
+            held = parse;
+         batch.push(command);
+         stats.items++;
+      }
+
+      if (!batch.empty() && (done || batch.size() >= BATCH_SIZE ||
+                             parse - held >= MAX_HOLD ||
+                             in.rdbuf()->in_avail() <= 0))
+      {
+         chrono::steady_clock::time_point wait = chrono::steady_clock::now();
+         commands.pushBatch(batch);
+         waiting += secondsSince(wait);
+         stats.batches++;
+      }
+   }
+   commands.close();
+
+   stats.wall = secondsSince(start);
+   stats.busy = stats.wall - waiting;
+}
+
+/********************************************
+ * MATCH STAGE
+ * Apply the commands to the portfolio, matching sells
+ * against the oldest lots first. A lots report is passed
+ * on as a snapshot for the report stage to walk, so a big
+ * portfolio does not hold up the trades behind it
+ *******************************************/
+static void matchStage(BoundedQueue <Command> & commands,
+                       BoundedQueue <Event> & events, StageStats & stats)
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   stats.core = pinToCore(PipelineStats::MATCH);
+   double waiting = 0.0;
+
+   PortfolioHistory portfolio;
+   Queue <Command> batch(BATCH_SIZE);
+   Queue <Event> output(BATCH_SIZE);
+   for (;;)
+   {
+      chrono::steady_clock::time_point wait = chrono::steady_clock::now();
+      bool more = commands.popBatch(batch, BATCH_SIZE);
+      waiting += secondsSince(wait);
+      if (!more)
+         break;
+
+      stats.items += batch.size();
+      stats.batches++;
+      Command command;
+      while (batch.tryPop(command))
+         portfolio.apply(command, output);
+      batch.clear();
+
+      wait = chrono::steady_clock::now();
+      events.pushBatch(output);
+      waiting += secondsSince(wait);
+   }
+   events.close();
+
+   stats.wall = secondsSince(start);
+   stats.busy = stats.wall - waiting;
+}
+
+/********************************************
+ * REPORT STAGE
+ * Format the events into the writer and hand each batch
+ * to the operating system with one write(2)
+ *******************************************/
+static void reportStage(BoundedQueue <Event> & events, ReportWriter & out,
+                        StageStats & stats)
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   stats.core = pinToCore(PipelineStats::REPORT);
+   double waiting = 0.0;
+
+   Queue <Event> batch(BATCH_SIZE);
+   for (;;)
+   {
+      chrono::steady_clock::time_point wait = chrono::steady_clock::now();
+      bool more = events.popBatch(batch, BATCH_SIZE);
+      waiting += secondsSince(wait);
+      if (!more)
+         break;
+
+      stats.items += batch.size();
+      stats.batches++;
+      Event event;
+      while (batch.tryPop(event))
+         out << event;
+      batch.clear();
+      out.flush();
+   }
+
+   stats.wall = secondsSince(start);
+   stats.busy = stats.wall - waiting;
+}
+
+/************************************************
+ * STOCKS PIPELINE
+ * The same program as stocksBuySell() but with reading,
+ * matching, and writing each on its own thread
+ ***********************************************/
+void stocksPipeline(istream & in, ReportWriter & out, PipelineStats & stats)
+{
+   stats.stages[PipelineStats::PARSE].name  = "parse";
+   stats.stages[PipelineStats::MATCH].name  = "match";
+   stats.stages[PipelineStats::REPORT].name = "report";
+
+   BoundedQueue <Command> commands(RING_SIZE);
+   BoundedQueue <Event>   events(RING_SIZE);
+
+   thread parse(parseStage, ref(in), ref(commands),
+                ref(stats.stages[PipelineStats::PARSE]));
+   thread match(matchStage, ref(commands), ref(events),
+                ref(stats.stages[PipelineStats::MATCH]));
+   thread report(reportStage, ref(events), ref(out),
+                 ref(stats.stages[PipelineStats::REPORT]));
+
+   parse.join();
+   match.join();
+   report.join();
+}
+
+/*******************************************
+ * PIPELINE STATS DISPLAY
+ * One line per stage:
+ *    parse   core 0   12 batches    700 items   busy 35.2%
+ ******************************************/
+ostream & operator << (ostream & out, const PipelineStats & rhs)
+{
+   for (int i = 0; i < PipelineStats::NUM_STAGES; i++)
+   {
+      const StageStats & stage = rhs.stages[i];
+      out << stage.name << "\t";
+      if (stage.core >= 0)
+         out << "core " << stage.core << "\t";
+      else
+         out << "unpinned\t";
+      out << stage.batches << " batches\t"
+          << stage.items   << " items\t"
+          << "busy " << (int)(stage.utilization() * 1000.0) / 10.0 << "%\n";
+   }
+   return out;
+}
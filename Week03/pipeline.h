@@ -0,0 +1,155 @@
+/***********************************************************************
+ * Header:
+ *    PIPELINE
+ * Summary:
+ *    The pieces needed to run the stock program as three stages,
+ *    each on its own thread:
+ *        parse  : tokenize the text into commands
+ *        match  : apply the commands to the portfolio
+ *        report : format the events into text
+ *    The stages hand batches to each other through bounded queues.
+ *
+ *    This will contain the class definition of:
+ *        BoundedQueue     : a fixed size Queue shared by two threads
+ *        StageStats       : how busy one stage of the pipeline was
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <mutex>               // for MUTEX
+#include <condition_variable>  // for CONDITION_VARIABLE
+#include <iostream>            // for ISTREAM and OSTREAM
+#include "queue.h"             // for QUEUE
+#include "reportWriter.h"      // for REPORT_WRITER
+
+/************************************************
+ * BOUNDED QUEUE
+ * A ring buffer of a fixed number of items handed from
+ * one thread to another. Items move a batch at a time so
+ * the lock is taken once per batch rather than once per item
+ ***********************************************/
+template <class T>
+class BoundedQueue
+{
+public:
+   // non-default constructor : the ring never grows past "capacity"
+   BoundedQueue(int capacity) : buffer(capacity), limit(capacity),
+                                closed(false) { assert(capacity > 0); }
+
+   // move every item of the batch in, waiting for room as needed
+   void pushBatch(Queue <T> & batch);
+
+   // move up to "max" items out, waiting for at least one.
+   // Returns false once the queue is closed and drained
+   bool popBatch(Queue <T> & batch, int max);
+
+   // no more items will be pushed
+   void close();
+
+private:
+   Queue <T> buffer;                  // the items in flight
+   int limit;                         // most items the buffer may hold
+   bool closed;                       // has the producer finished?
+   std::mutex lock;                   // protects everything above
+   std::condition_variable notEmpty;  // signalled when items arrive
+   std::condition_variable notFull;   // signalled when items leave
+};
+
+/**************************************
+ * BOUNDED QUEUE :: PUSH BATCH
+ * Copy in as much as fits, then wait for the consumer
+ ***************************************/
+template <class T>
+void BoundedQueue <T> :: pushBatch(Queue <T> & batch)
+{
+   std::unique_lock <std::mutex> guard(lock);
+   while (!batch.empty())
+   {
+      while (buffer.size() >= limit && !closed)
+         notFull.wait(guard);
+      if (closed)
+         break;
+
+      T item;
+      while (buffer.size() < limit && batch.tryPop(item))
+         buffer.push(item);
+      notEmpty.notify_one();
+   }
+   batch.clear();
+}
+
+/**************************************
+ * BOUNDED QUEUE :: POP BATCH
+ * Take what is there, up to "max" items
+ ***************************************/
+template <class T>
+bool BoundedQueue <T> :: popBatch(Queue <T> & batch, int max)
+{
+   std::unique_lock <std::mutex> guard(lock);
+   while (buffer.empty() && !closed)
+      notEmpty.wait(guard);
+   if (buffer.empty())
+      return false;
+
+   T item;
+   for (int i = 0; i < max && buffer.tryPop(item); i++)
+      batch.push(item);
+   notFull.notify_one();
+   return true;
+}
+
+/**************************************
+ * BOUNDED QUEUE :: CLOSE
+ * Wake everyone up: the producer is done
+ ***************************************/
+template <class T>
+void BoundedQueue <T> :: close()
+{
+   std::lock_guard <std::mutex> guard(lock);
+   closed = true;
+   notEmpty.notify_all();
+   notFull.notify_all();
+}
+
+/************************************************
+ * STAGE STATS
+ * How much of its life a stage spent working rather
+ * than waiting on the stages next to it
+ ***********************************************/
+struct StageStats
+{
+   StageStats() : name(""), core(-1), batches(0), items(0),
+                  busy(0.0), wall(0.0) {}
+
+   // the fraction of the time the stage was doing work
+   double utilization() const { return wall > 0.0 ? busy / wall : 0.0; }
+
+   const char * name;   // parse, match, or report
+   int    core;         // the core the stage was pinned to, -1 if none
+   int    batches;      // how many batches the stage handled
+   long   items;        // how many items the stage handled
+   double busy;         // seconds spent working
+   double wall;         // seconds from start to finish
+};
+
+/************************************************
+ * PIPELINE STATS
+ * One entry for each of the three stages
+ ***********************************************/
+struct PipelineStats
+{
+   enum { PARSE, MATCH, REPORT, NUM_STAGES };
+   StageStats stages[NUM_STAGES];
+};
+
+// display the utilization of each stage
+std::ostream & operator << (std::ostream & out, const PipelineStats & rhs);
+
+// run the stock program as a three stage pipeline
+void stocksPipeline(std::istream & in, ReportWriter & out,
+                    PipelineStats & stats);
+
+#endif // PIPELINE_H
@@ -0,0 +1,108 @@
+/***********************************************************************
+ * Implementation:
+ *    PRICE WINDOW
+ * Summary:
+ *    Sliding window min, max, and VWAP over a Queue of trades
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cassert>         // for ASSERT
+#include "priceWindow.h"   // for PRICE_WINDOW
+using namespace std;
+
+/********************************************
+ * PRICE WINDOW :: PUSH
+ * A new trade knocks out every candidate it beats:
+ * a lower price can never again be the max while this
+ * trade is in the window, and likewise for the min
+ *******************************************/
+void PriceWindow :: push(const Trade & trade)
+{
+   assert(trades.empty() || trades.back().time <= trade.time);
+
+   if (maxTrades > 0 && trades.size() == maxTrades)
+      evict();
+
+   Candidate candidate(nextSeq++, trade.price);
+   while (!lows.empty() && lows.back().price >= trade.price)
+      lows.popBack();
+   lows.push(candidate);
+   while (!highs.empty() && highs.back().price <= trade.price)
+      highs.popBack();
+   highs.push(candidate);
+
+   trades.push(trade);
+   notional += (long long)trade.shares * trade.price.getCents();
+   volume   += trade.shares;
+}
+
+/********************************************
+ * PRICE WINDOW :: EVICT OLDER THAN
+ *******************************************/
+void PriceWindow :: evictOlderThan(long long time)
+{
+   while (!trades.empty() && trades.front().time < time)
+      evict();
+}
+
+/********************************************
+ * PRICE WINDOW :: EVICT
+ * Take away the oldest trade. If it was the min or the
+ * max it is at the front of that Queue
+ *******************************************/
+void PriceWindow :: evict()
+{
+   assert(!trades.empty());
+   const Trade & oldest = trades.front();
+   notional -= (long long)oldest.shares * oldest.price.getCents();
+   volume   -= oldest.shares;
+
+   long long seq = nextSeq - trades.size();
+   if (lows.front().seq == seq)
+      lows.pop();
+   if (highs.front().seq == seq)
+      highs.pop();
+   trades.pop();
+
+   // an empty Queue can start again at the beginning of its buffer
+   if (trades.empty())
+   {
+      trades.clear();
+      lows.clear();
+      highs.clear();
+   }
+}
+
+/********************************************
+ * PRICE WINDOW :: MIN
+ *******************************************/
+Dollars PriceWindow :: min() const
+{
+   if (trades.empty())
+      throw "ERROR: no trades in the window";
+   return lows.front().price;
+}
+
+/********************************************
+ * PRICE WINDOW :: MAX
+ *******************************************/
+Dollars PriceWindow :: max() const
+{
+   if (trades.empty())
+      throw "ERROR: no trades in the window";
+   return highs.front().price;
+}
+
+/********************************************
+ * PRICE WINDOW :: VWAP
+ * The running sums divided, to the nearest cent
+ *******************************************/
+Dollars PriceWindow :: vwap() const
+{
+   if (trades.empty() || volume == 0)
+      throw "ERROR: no trades in the window";
+   long long cents = (notional * 2 + (notional < 0 ? -volume : volume)) /
+                     (volume * 2);
+   return Dollars((int)cents);
+}
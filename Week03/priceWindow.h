@@ -0,0 +1,97 @@
+/***********************************************************************
+ * Header:
+ *    PRICE WINDOW
+ * Summary:
+ *    The lowest price, the highest price, and the volume weighted
+ *    average price over the most recent trades, for risk checks. The
+ *    window can be the last N trades, the trades since some time, or
+ *    both. Every answer is O(1) and every trade costs O(1) amortized:
+ *        - the running sums give the VWAP
+ *        - the min and the max come from monotonic Queues, which only
+ *          keep the trades that could still be the min or the max
+ *
+ *    This will contain the class definition of:
+ *        Trade            : one trade at a time
+ *        PriceWindow      : the aggregates over the recent trades
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef PRICE_WINDOW_H
+#define PRICE_WINDOW_H
+
+#include "dollars.h"   // for DOLLARS
+#include "queue.h"     // for QUEUE
+
+/******************************************
+ * TRADE
+ * A number of shares that traded at a price at a time
+ ******************************************/
+struct Trade
+{
+   Trade() : time(0), shares(0), price() {}
+   Trade(long long time, int shares, const Dollars & price) :
+      time(time), shares(shares), price(price) {}
+
+   long long time;     // when it traded, in whatever units the caller likes
+   int       shares;
+   Dollars   price;
+};
+
+/******************************************
+ * PRICE WINDOW
+ * Aggregates over a sliding window of trades. Trades must
+ * be pushed in time order
+ ******************************************/
+class PriceWindow
+{
+public:
+   // non-default constructor : keep at most "maxTrades" trades, or
+   // every trade until they are evicted by time if it is 0
+   PriceWindow(int maxTrades = 0) : maxTrades(maxTrades), nextSeq(0),
+                                    notional(0), volume(0) {}
+
+   // add a trade, dropping the oldest if the window is full
+   void push(const Trade & trade);
+
+   // drop every trade from before "time"
+   void evictOlderThan(long long time);
+
+   // how many trades are in the window
+   int size() const     { return trades.size();  }
+   bool empty() const   { return trades.empty(); }
+
+   // the aggregates. The window must not be empty
+   Dollars min() const;
+   Dollars max() const;
+   Dollars vwap() const;
+   long long getVolume() const { return volume; }
+
+private:
+   /******************************************
+    * CANDIDATE
+    * A trade that could still be the min or the max,
+    * remembered by its position in the stream
+    ******************************************/
+   struct Candidate
+   {
+      Candidate() : seq(0), price() {}
+      Candidate(long long seq, const Dollars & price) :
+         seq(seq), price(price) {}
+      long long seq;
+      Dollars price;
+   };
+
+   // drop the oldest trade
+   void evict();
+
+   int maxTrades;                // 0 for no limit
+   long long nextSeq;            // the position of the next trade
+   Queue <Trade> trades;         // the window, oldest first
+   Queue <Candidate> lows;       // rising prices: the front is the min
+   Queue <Candidate> highs;      // falling prices: the front is the max
+   long long notional;           // sum of shares times cents
+   long long volume;             // sum of shares
+};
+
+#endif // PRICE_WINDOW_H
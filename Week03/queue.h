@@ -18,6 +18,10 @@
 #define Queue_H
 
 #include <cassert>
+#include <new>           // for NOTHROW and BAD_ALLOC
+#include <optional>      // for OPTIONAL
+#include <type_traits>   // for IS_NOTHROW_MOVE_ASSIGNABLE
+#include <utility>       // for MOVE_IF_NOEXCEPT
 
 /************************************************
  * Queue
@@ -28,86 +32,167 @@ class Queue
 {
 public:
    // default constructor : empty and kinda useless
-   Queue() : numItems(0), vCapacity(0), data(NULL), locHead(0), locTail(0) {}
+   Queue() noexcept : vCapacity(0), data(NULL), countIn(0), countOut(0) {}
 
    // copy constructor : copy it
-   Queue(const Queue & rhs) throw (const char *);
+   Queue(const Queue & rhs);
 
    // non-default constructor : pre-allocate
-   Queue(int vCapacity) throw (const char *);
+   Queue(int vCapacity);
 
    // destructor : free everything
-   ~Queue()        {if (vCapacity) delete [] data; }
+   ~Queue() noexcept {if (vCapacity) delete [] data; }
 
    // is the container currently empty
-   bool empty() const   { return (locHead - locTail) == 0; }
+   bool empty() const noexcept { return numItems() == 0; }
 
    // remove all the items from the container
-   void clear()         { locHead = 0; locTail = 0;        }
+   void clear() noexcept  { countIn = 0; countOut = 0;        }
 
    // how many items are currently in the container?
-   int size() const     { return locTail - locHead;        }
-   int capacity() const { return vCapacity;                }
+   int size() const noexcept { return countIn - countOut;        }
+   int capacity() const noexcept { return vCapacity;                }
 
-   // return item at the front of the Queue
-   T front() const throw (const char *)
+   // get the item from the front of the Queue
+   T & front();
+   const T & front() const
+      { return const_cast <Queue <T> *> (this)->front(); }
+
+   // the same without throwing: an empty optional if there is nothing
+   std::optional <T> tryFront() const
+      noexcept(std::is_nothrow_copy_constructible <T> ::value)
    {
-      if (numItems == 0)
-      {
-         throw "ERROR: Unable to reference the element from an empty Queue";
-      }
-      return data[locHead++];
+      if (numItems() == 0)
+         return std::nullopt;
+      return data[locHead()];
    }
 
    // add an item to the Queue
-   void push(const T &t) throw (const char *);
+   void push(const T &t);
+
+   //resize the Queue
+   void resize();
 
    // remove top item from the Queue
-   void pop() throw (const char *);
+   void pop();
 
+   // move the front item into "t" and remove it. False if it is empty,
+   // so a consumer polling a queue that is often empty never throws
+   bool tryPop(T & t) noexcept(std::is_nothrow_move_assignable <T> ::value)
+   {
+      if (numItems() == 0)
+         return false;
+      t = std::move(data[locHead()]);
+      countOut++;
+      rebase();
+      return true;
+   }
 
-   /************************************************
-   * Container :: assignment
-   * Assign a value to a container
-   *************************************************/
-   Queue <T> &operator = (const Queue<T> &rhs) throw (const char*)
+   // remove the item at the back of the Queue
+   void popBack();
+
+   // return the item at the back of the Queue
+   T &back();
+   const T &back() const
+      { return const_cast <Queue <T> *> (this)->back(); }
+
+   // overloaded assignment operator
+   Queue <T> &operator = (const Queue<T> &rhs)
    {
-      try
+      if (this == &rhs)
+         return *this;
+
+      T * temp = NULL;
+      if (rhs.vCapacity)
       {
-         this->data = new T[rhs.vCapacity];
-         this->vCapacity = rhs.vCapacity;
-         this->numItems = rhs.numItems;
+         try
+         {
+            temp = new T[rhs.vCapacity];
+         }
+         catch (std::bad_alloc)
+         {
+            throw "ERROR: Can not allocate buffer for new Queue";
+         }
+      }
 
-         int x = locHead;
+      // line the items up at the start of the new buffer. If copying
+      // one throws, this Queue is left as it was
+      try
+      {
+         int x = rhs.locHead();
          for (int i = 0; i < rhs.size(); i++)
          {
-            this->data[i] = rhs.data[x];
+            if (x == (rhs.vCapacity))
+            {
+               x = 0;
+            }
+            temp[i] = rhs.data[x];
             x++;
          }
       }
-      catch (std::bad_alloc)
+      catch (...)
       {
-         throw "ERROR: Can not allocate buffer for new Queue";
+         delete [] temp;
+         throw;
       }
-   return *this;
+
+      if (vCapacity)
+         delete [] data;
+      this->data = temp;
+      this->vCapacity = rhs.vCapacity;
+      this->countIn = rhs.size();
+      this->countOut = 0;
+      return *this;
    }
 
    // overloaded []
-   T &operator[] (int index) throw (const char*)
+   T &operator[] (int index) noexcept
+      { return data[index]; }
+   const T &operator[] (int index) const noexcept
+      { return data[index]; }
+
+private:
+   T * data;          // dynamically allocated array of T
+   int numItems() const noexcept {return countIn - countOut;}      // how many items are currently in the Container?
+   int locHead() const noexcept
+    {
+      if(vCapacity == 0)
+      {
+         return 0;
+      }
+      else
+      {
+         return (countOut % vCapacity);
+      }
+   } // the location of the head
+
+   // keep the counts from growing without bound in a ring that is
+   // pushed and popped forever without ever filling. Taking a whole
+   // lap off both leaves the size and every location where it was
+   void rebase() noexcept
    {
-      return data[index];
+      if (countOut >= vCapacity)
+      {
+         countOut -= vCapacity;
+         countIn -= vCapacity;
+      }
    }
-   const T &operator[] (int index) const throw (const char*)
+
+   int locTail() const noexcept
    {
-      return data[index];
-   }
+      if (vCapacity == 0)
+      {
+         return 0;
+      }
+      else
+      {
+         return (countIn % vCapacity);
+      }
+   }     // the location of the tail
 
-private:
-   T * data;          // dynamically allocated array of T
-   int numItems = locTail - locHead; // how many items are currently in the Container?
    int vCapacity;     // how many items can I put on the Container before full?
-   int locHead;       // the location of the head
-   int locTail;       // the location of the tail
+   int countIn;       // the number of items added to queue
+   int countOut;      // the number of items removed from queue
 };
 
 
@@ -115,14 +200,16 @@ private:
  * CONTAINER :: COPY CONSTRUCTOR
  *******************************************/
 template <class T>
-Queue <T> :: Queue(const Queue <T> & rhs) throw (const char *)
+Queue <T> :: Queue(const Queue <T> & rhs)
 {
    assert(rhs.vCapacity >= 0);
+   this->countIn = 0;
+   this->countOut = 0;
 
    // do nothing if there is nothing to do
    if (rhs.vCapacity == 0)
    {
-      vCapacity = numItems = 0;
+      vCapacity = 0;
       data = NULL;
       return;
    }
@@ -137,18 +224,25 @@ Queue <T> :: Queue(const Queue <T> & rhs) throw (const char *)
       throw "ERROR: Unable to allocate buffer";
    }
 
-   // copy over the capacity and size
-   assert(rhs.numItems >= 0 && rhs.numItems <= rhs.vCapacity);
+   // copy over the capacity, size and counts (for head and tail locations)
+   this->countOut = rhs.countOut;
+   this->countIn = rhs.countIn;
+   assert(rhs.numItems() >= 0 && rhs.numItems() <= rhs.vCapacity);
    vCapacity = rhs.vCapacity;
-   numItems = rhs.numItems;
 
-   // copy the items over one at a time using the assignment operator
-   for (int i = 0; i < numItems; i++)
-      data[i] = rhs.data[i];
-
-   // the rest needs to be filled with the default value for T
-   for (int i = numItems; i < vCapacity; i++)
-      data[i] = T();
+   // copy the items over one at a time using the assignment operator.
+   // No destructor runs for a constructor that throws, so free the
+   // buffer ourselves
+   try
+   {
+      for (int i = 0; i < vCapacity; i++)
+         data[i] = rhs.data[i];
+   }
+   catch (...)
+   {
+      delete [] data;
+      throw;
+   }
 }
 
 /**********************************************
@@ -156,14 +250,16 @@ Queue <T> :: Queue(const Queue <T> & rhs) throw (const char *)
  * Preallocate the container to "capacity"
  **********************************************/
 template <class T>
-Queue <T> :: Queue(int vCapacity) throw (const char *)
+Queue <T> :: Queue(int vCapacity)
 {
    assert(vCapacity >= 0);
    // do nothing if there is nothing to do
    if (vCapacity == 0)
    {
-      this->vCapacity = this->numItems = 0;
+      this->vCapacity = 0;
       this->data = NULL;
+      this->countIn = 0;
+      this->countOut = 0;
       return;
    }
    // attempt to allocate
@@ -177,7 +273,8 @@ Queue <T> :: Queue(int vCapacity) throw (const char *)
    }
    // copy over the stuff
    this->vCapacity = vCapacity;
-   this->numItems = 0;
+   this->countIn = 0;
+   this->countOut = 0;
    // initialize the container by calling the default constructor
    for (int i = 0; i < vCapacity; i++)
       data[i] = T();
@@ -188,13 +285,28 @@ Queue <T> :: Queue(int vCapacity) throw (const char *)
 *  remove the item on top of the Queue
 ***************************************/
 template <class T>
-void Queue<T> :: pop() throw (const char *)
+void Queue<T> :: pop()
 {
-   if (numItems == 0)
+   if (numItems() == 0)
    {
-      throw "ERROR: Unable to pop from an empty Queue";
+      throw "ERROR: attempting to pop from an empty queue";
    }
-   locHead++;
+   countOut++;
+   rebase();
+}
+
+/**************************************
+*  Queue :: POP BACK
+*  remove the item most recently pushed
+***************************************/
+template <class T>
+void Queue<T> :: popBack()
+{
+   if (numItems() == 0)
+   {
+      throw "ERROR: attempting to pop from an empty queue";
+   }
+   countIn--;
 }
 
 /**************************************
@@ -202,42 +314,94 @@ void Queue<T> :: pop() throw (const char *)
 *  add a new item to the top of the Queue
 ***************************************/
 template <class T>
-void Queue <T> ::push(const T &t) throw (const char *)
+void Queue <T> :: push(const T &t)
+{
+   resize();
+   data[locTail()] = t;
+   countIn++;
+}
+
+/**************************************
+* QUEUE :: FRONT
+* return the item at the front of the queue
+***************************************/
+template <class T>
+T & Queue <T> :: front()
+{
+   if (this->empty())
+   {
+      throw "ERROR: attempting to access an item in an empty queue";
+   }
+   else
+   {
+      return this->data[locHead()];
+   }
+};
+
+/**************************************
+* QUEUE :: RESIZE
+* rewrite the Queue into a Queue of a larger size
+***************************************/
+template <class T>
+void Queue <T> :: resize()
 {
    if (vCapacity == 0)
    {
       vCapacity = 1;
       data = new T[vCapacity];
    }
-
-   if (vCapacity - 1 == numItems)
+   if (numItems() == vCapacity)
    {
-      this->vCapacity *= 2;
+      // allocate before touching anything, so a failure leaves the
+      // Queue as it was
+      T * temp = new(std::nothrow) T[vCapacity * 2];
+      if (temp == NULL)
+         throw "Error: Cannot allocate buffer";
 
+      // move the items over when that cannot throw, else copy them,
+      // so if a copy throws the old buffer is still whole
       try
       {
-         T * temp = new(std::nothrow) T[vCapacity];
-
-         for (int i = 0; i < numItems; i++)
+         int x = locHead();
+         for (int i = 0; i < numItems(); i++)
          {
-            temp[i] = data[i];
+            if (x == vCapacity)
+            {
+               x = 0;
+            }
+            temp[i] = std::move_if_noexcept(data[x]);
+            x++;
          }
-
-         delete [] data;
-         data = temp;
       }
-
-      catch(std::bad_alloc)
+      catch (...)
       {
-         throw "Error: Cannot allocate buffer";
+         delete [] temp;
+         throw;
       }
+
+      delete [] data;
+
+      data = temp;
+      vCapacity *= 2;
+      countIn = numItems();
+      countOut = 0;
    }
+}
 
-   if (numItems < vCapacity)
+/**************************************
+* QUEUE :: BACK
+* returns the item at the back of the Queue
+***************************************/
+template<class T>
+T &Queue <T> :: back()
+{
+   if (this->empty())
    {
-      data[numItems] = t;
-      numItems++;
+      throw "ERROR: attempting to access an item in an empty queue";
    }
+   return this->data[(countIn - 1) % vCapacity];
 }
 
+
+
 #endif // Queue_H
@@ -0,0 +1,2414 @@
+/***********************************************************************
+* Program:
+*    QUEUE TEST
+* Summary:
+*    A non-interactive test for the Queue class. The same long random
+*    sequence of operations is applied to a Queue and to a std::deque
+*    and after every step the two must agree. The sequences wrap around
+*    the ring, grow it mid-wrap, and copy and assign it, which are the
+*    places a circular buffer goes wrong.
+*
+*    Run with no arguments for a fixed set of seeds, or
+*        queueTest <seed> <operations>
+*    to reproduce a failure.
+* Author
+*    <your names here>
+************************************************************************/
+
+#include <iostream>    // for COUT
+#include <string>      // for STRING
+#include <deque>       // for DEQUE, what we compare against
+#include <vector>      // for VECTOR
+#include <sstream>     // for OSTRINGSTREAM
+#include <climits>     // for INT_MIN and LLONG_MIN
+#include <algorithm>   // for SORT
+#include <unordered_map> // for UNORDERED_MAP, what we compare against
+#include <random>      // for MT19937
+#include <cstdlib>     // for ATOI
+#include <cstring>     // for MEMSET, STRCPY, and STRCMP
+#include <unistd.h>    // for FORK
+#include <sys/wait.h>  // for WAITPID
+#include <sys/file.h>  // for FLOCK
+#include <sys/socket.h> // for SOCKET and SEND
+#include <sys/un.h>    // for SOCKADDR_UN
+#include <fcntl.h>     // for FCNTL
+#include <csignal>     // for KILL
+#include <thread>      // for THREAD
+#include <atomic>      // for ATOMIC
+#include "queue.h"     // for QUEUE
+#include "lotQueue.h"  // for LOT_QUEUE
+#include "lotBook.h"   // for LOT_BOOK
+#include "shmQueue.h"  // for SHM_QUEUE
+#include "workDeque.h" // for WORK_DEQUE
+#include "staticQueue.h" // for STATIC_QUEUE
+#include "largeQueue.h" // for LARGE_QUEUE
+#include "journalCodec.h" // for JOURNAL_ENCODER and JOURNAL_DECODER
+#include "latency.h"   // for LATENCY_HISTOGRAM and LATENCY_RECORDER
+#include "symbolTable.h" // for SYMBOL_TABLE and TRADE_RECORD
+#include "cowQueue.h"  // for COW_QUEUE
+#include "priceWindow.h" // for PRICE_WINDOW
+#include "reportWriter.h" // for REPORT_WRITER
+#include "stock.h"     // for PORTFOLIO_HISTORY
+#include "pipeline.h"  // for STOCKS_PIPELINE
+#include "server.h"    // for STOCK_SERVER
+#include "orderBook.h" // for ORDER_BOOK
+#include "mapBook.h"   // for MAP_BOOK, what we compare against
+#include "dollars.h"   // for DOLLARS
+#include "fixedPoint.h" // for FIXED_POINT
+using namespace std;
+
+/*******************************************
+ * FAILURE
+ * Thrown when the Queue and the deque disagree
+ *******************************************/
+struct Failure
+{
+   Failure(const char * what, long step) : what(what), step(step) {}
+   const char * what;
+   long step;
+};
+
+/*******************************************
+ * CHECK
+ * Stop the run if a condition does not hold
+ *******************************************/
+#define CHECK(condition, step)                          \
+   do                                                   \
+   {                                                    \
+      if (!(condition))                                 \
+         throw Failure(#condition, step);               \
+   }                                                    \
+   while (false)
+
+/*******************************************
+ * RANDOM VALUE
+ * Something to push for each type we test
+ *******************************************/
+int randomValue(mt19937 & random, int *)
+{
+   return (int)random();
+}
+string randomValue(mt19937 & random, string *)
+{
+   // long enough that copies really allocate
+   return string(random() % 40, (char)('a' + random() % 26));
+}
+Dollars randomValue(mt19937 & random, Dollars *)
+{
+   return Dollars((int)(random() % 100000) - 50000);
+}
+
+/*******************************************
+ * THROWS
+ * Did accessing the Queue throw the error message?
+ *******************************************/
+template <class Function>
+bool throws(Function function)
+{
+   try
+   {
+      function();
+   }
+   catch (const char *)
+   {
+      return true;
+   }
+   return false;
+}
+
+/*******************************************
+ * SAME
+ * Do the Queue and the deque hold the same items in the
+ * same order? The Queue is passed by value so this also
+ * exercises the copy constructor
+ *******************************************/
+template <class T>
+void same(Queue <T> q, const deque <T> & d, long step)
+{
+   CHECK(q.size() == (int)d.size(), step);
+   CHECK(q.empty() == d.empty(), step);
+   CHECK(q.capacity() >= q.size(), step);
+   for (typename deque <T> ::const_iterator it = d.begin(); it != d.end();
+        ++it)
+   {
+      CHECK(q.front() == *it, step);
+      q.pop();
+   }
+   CHECK(q.empty(), step);
+}
+
+/*******************************************
+ * COMPARE
+ * The cheap checks made after every step
+ *******************************************/
+template <class T>
+void compare(Queue <T> & q, const deque <T> & d, long step)
+{
+   CHECK(q.size() == (int)d.size(), step);
+   CHECK(q.empty() == d.empty(), step);
+   if (d.empty())
+   {
+      CHECK(throws([&]() { q.front(); }), step);
+      CHECK(throws([&]() { q.back();  }), step);
+      CHECK(!q.tryFront(), step);
+   }
+   else
+   {
+      CHECK(q.front() == d.front(), step);
+      CHECK(q.tryFront() && *q.tryFront() == d.front(), step);
+      CHECK(q.back()  == d.back(),  step);
+   }
+}
+
+/*******************************************
+ * TEST QUEUE
+ * One random run for one type
+ *******************************************/
+template <class T>
+void testQueue(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   Queue <T> q(random() % 4);
+   deque <T> d;
+
+   for (long step = 0; step < operations; step++)
+   {
+      int op = random() % 100;
+      if (op < 45)
+      {
+         // push, usually in a burst so the ring fills and wraps
+         int count = (random() % 4 == 0) ? random() % 20 : 1;
+         for (int i = 0; i < count; i++)
+         {
+            T value = randomValue(random, (T *)NULL);
+            q.push(value);
+            d.push_back(value);
+         }
+      }
+      else if (op < 75)
+      {
+         if (d.empty())
+         {
+            CHECK(throws([&]() { q.pop(); }), step);
+            T item;
+            CHECK(!q.tryPop(item), step);
+         }
+         else if (op < 60)
+         {
+            q.pop();
+            d.pop_front();
+         }
+         else
+         {
+            T item;
+            CHECK(q.tryPop(item) && item == d.front(), step);
+            d.pop_front();
+         }
+      }
+      else if (op < 80)
+      {
+         if (d.empty())
+         {
+            CHECK(throws([&]() { q.popBack(); }), step);
+         }
+         else
+         {
+            q.popBack();
+            d.pop_back();
+         }
+      }
+      else if (op < 85)
+      {
+         // growing is a no-op until the ring is full
+         q.resize();
+      }
+      else if (op < 90)
+      {
+         // carry on with a copy
+         Queue <T> copy(q);
+         same(copy, d, step);
+         q = copy;
+      }
+      else if (op < 95)
+      {
+         // assign over a queue that already has something in it
+         Queue <T> other(random() % 8);
+         other.push(randomValue(random, (T *)NULL));
+         other = q;
+         same(other, d, step);
+         q = other;
+      }
+      else if (op < 97)
+      {
+         Queue <T> & self = q;
+         q = self;
+      }
+      else if (op < 98)
+      {
+         q.clear();
+         d.clear();
+      }
+      else
+         same(q, d, step);
+
+      compare(q, d, step);
+   }
+   same(q, d, operations);
+}
+
+/*******************************************
+ * FRAGILE
+ * An item whose copies throw once "left" runs out
+ *******************************************/
+struct Fragile
+{
+   Fragile(int value = 0) : value(value) {}
+   Fragile(const Fragile & rhs) : value(rhs.value) { tick(); }
+   Fragile & operator = (const Fragile & rhs)
+   {
+      tick();
+      value = rhs.value;
+      return *this;
+   }
+   bool operator == (const Fragile & rhs) const { return value == rhs.value; }
+
+   static void tick()
+   {
+      if (left >= 0 && left-- == 0)
+         throw "ERROR: copying failed";
+   }
+
+   int value;
+   static int left;     // copies until one throws, or negative for never
+};
+int Fragile::left = -1;
+
+/*******************************************
+ * TEST QUEUE THROWS
+ * A copy that throws while the Queue grows, is copied,
+ * or is assigned leaves it as it was and leaks nothing.
+ * The leak checker sees to the second part
+ *******************************************/
+void testQueueThrows(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   Queue <Fragile> q(random() % 4);
+   deque <Fragile> d;
+
+   for (long step = 0; step < operations; step++)
+   {
+      Fragile::left = -1;
+      int op = random() % 4;
+      if (op == 0 || d.empty())
+      {
+         Fragile value((int)step);
+         Fragile::left = random() % 8;
+         try
+         {
+            q.push(value);
+            Fragile::left = -1;
+            d.push_back(value);
+         }
+         catch (const char *)
+         {
+         }
+      }
+      else if (op == 1)
+      {
+         q.pop();
+         d.pop_front();
+      }
+      else if (op == 2)
+      {
+         Fragile::left = random() % (d.size() + 1);
+         bool fails = Fragile::left < q.capacity();
+         CHECK(throws([&]() { Queue <Fragile> copy(q); }) == fails, step);
+      }
+      else
+      {
+         Queue <Fragile> other(random() % 4);
+         Fragile::left = random() % (d.size() + 1);
+         bool fails = Fragile::left < (int)d.size();
+         CHECK(throws([&]() { other = q; }) == fails, step);
+      }
+
+      Fragile::left = -1;
+      CHECK(q.size() == (int)d.size(), step);
+      if (!d.empty())
+         CHECK(q.front() == d.front() && q.back() == d.back(), step);
+   }
+}
+
+/*******************************************
+ * STATIC QUEUE WRAP
+ * A StaticQueue is constexpr: push past the end of a
+ * small one, popping as we go, while compiling
+ *******************************************/
+constexpr int staticQueueWrap()
+{
+   StaticQueue <int, 4> q;
+   int sum = 0;
+   for (int i = 1; i <= 10; i++)
+   {
+      if (!q.tryPush(i))
+      {
+         sum += q.front();
+         q.pop();
+         q.push(i);   // there is room now that one is gone
+      }
+   }
+   while (q.size() > 1)
+   {
+      sum += q.back();
+      q.popBack();
+   }
+   return sum * 100 + q.front();
+}
+static_assert(staticQueueWrap() == (1 + 2 + 3 + 4 + 5 + 6 + 8 + 9 + 10) * 100
+              + 7, "a StaticQueue works in a constant expression");
+
+/*******************************************
+ * TEST STATIC QUEUE
+ * A small StaticQueue against a deque that is never
+ * allowed more items than it would take. A push onto
+ * a full one throws; a tryPush() says no
+ *******************************************/
+template <class T>
+void testStaticQueue(unsigned int seed, long operations)
+{
+   typedef StaticQueue <T, 8> Fixed;
+   mt19937 random(seed);
+   Fixed q;
+   deque <T> d;
+
+   for (long step = 0; step < operations; step++)
+   {
+      int op = random() % 100;
+      if (op < 50)
+      {
+         T value = randomValue(random, (T *)NULL);
+         bool room = ((int)d.size() < q.capacity());
+         if (random() % 2)
+            CHECK(q.tryPush(value) == room, step);
+         else if (room)
+            q.push(value);
+         else
+            CHECK(throws([&]() { q.push(value); }), step);
+         CHECK(q.size() == (int)d.size() + room, step);
+         if (room)
+            d.push_back(value);
+      }
+      else if (op < 75)
+      {
+         T item;
+         CHECK(q.tryPop(item) == !d.empty(), step);
+         if (!d.empty())
+         {
+            CHECK(item == d.front(), step);
+            d.pop_front();
+         }
+      }
+      else if (op < 85 && !d.empty())
+      {
+         q.pop();
+         d.pop_front();
+      }
+      else if (op < 95 && !d.empty())
+      {
+         q.popBack();
+         d.pop_back();
+      }
+      else if (op < 98)
+      {
+         // carry on with a copy, which is every slot
+         Fixed copy(q);
+         q = copy;
+      }
+      else
+      {
+         q.clear();
+         d.clear();
+      }
+
+      CHECK(q.size() == (int)d.size(), step);
+      CHECK(q.empty() == d.empty(), step);
+      CHECK(!q.tryFront() == d.empty(), step);
+      if (!d.empty())
+      {
+         CHECK(q.front() == d.front() && *q.tryFront() == d.front(), step);
+         CHECK(q.back() == d.back(), step);
+      }
+   }
+}
+
+/*******************************************
+ * TEST LOT QUEUE
+ * The structure of arrays version against a deque of lots
+ *******************************************/
+void testLotQueue(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   LotQueue q(random() % 4);
+   deque <Lot> d;
+
+   for (long step = 0; step < operations; step++)
+   {
+      int op = random() % 100;
+      if (op < 45)
+      {
+         // often at the price of the lot before, so the lots merge
+         Dollars price = (!d.empty() && random() % 4 == 0) ? d.back().price :
+                         Dollars((int)(random() % 10000));
+         Lot lot(random() % 500 + 1, price, (int)step);
+         bool joins = !d.empty() && d.back().price == price;
+         CHECK(q.push(lot) == joins, step);
+         if (joins)
+            d.back().shares += lot.shares;
+         else
+            d.push_back(lot);
+      }
+      else if (op < 70)
+      {
+         if (d.empty())
+         {
+            CHECK(throws([&]() { q.pop(); }), step);
+         }
+         else
+         {
+            q.pop();
+            d.pop_front();
+         }
+      }
+      else if (op < 90)
+      {
+         if (!d.empty())
+         {
+            int take = random() % d.front().shares + 1;
+            q.takeFront(take);
+            if ((d.front().shares -= take) == 0)
+               d.pop_front();
+         }
+      }
+      else if (op < 95)
+      {
+         LotQueue copy(q);
+         q = copy;
+      }
+      else if (op < 96)
+      {
+         q.clear();
+         d.clear();
+      }
+      else if (op < 97)
+      {
+         // push() joined every neighbor it could, so nothing is left
+         // to merge, but the arrays shrink to fit
+         int before = q.capacity();
+         LotQueue::Compacted done = q.compact();
+         CHECK(done.merged == 0 && done.freed == before - q.capacity(),
+               step);
+         CHECK(q.capacity() == q.size(), step);
+      }
+      else
+      {
+         long long value = 0;
+         for (size_t i = 0; i < d.size(); i++)
+            value += (long long)d[i].shares * d[i].price.getCents();
+         CHECK(q.value() == value, step);
+
+         // how many lots from the front fill an order, across the wrap
+         int number = (int)(random() % 2000) + 1;
+         int lots = (int)d.size() + 1;
+         for (int i = 0, left = number; i < (int)d.size(); i++)
+            if ((left -= d[i].shares) <= 0)
+            {
+               lots = i + 1;
+               break;
+            }
+         CHECK(q.lotsToFill(number) == lots, step);
+      }
+
+      CHECK(q.size() == (int)d.size(), step);
+      if (!d.empty())
+      {
+         Lot front = q.front();
+         Lot back = q.back();
+         CHECK(front.shares == d.front().shares, step);
+         CHECK(front.price  == d.front().price,  step);
+         CHECK(front.seq    == d.front().seq,    step);
+         CHECK(back.seq     == d.back().seq,     step);
+      }
+   }
+
+   // lots too big to join when pushed are still too big to merge, but
+   // can be merged once some are sold
+   LotQueue big;
+   CHECK(!big.push(Lot(INT_MAX - 10, Dollars(100), 0)), operations);
+   CHECK(!big.push(Lot(20, Dollars(100), 1)), operations);
+   CHECK(!big.push(Lot(20, Dollars(200), 2)), operations);
+   LotQueue::Compacted done = big.compact();
+   CHECK(done.merged == 0 && done.freed == 1 && big.size() == 3,
+         operations);
+   big.takeFront(100);
+   done = big.compact();
+   CHECK(done.merged == 1 && done.freed == 1, operations);
+   CHECK(big.size() == 2 && big.front().shares == INT_MAX - 90 &&
+         big.back().price == Dollars(200), operations);
+}
+
+/*******************************************
+ * SELLS BEFORE
+ * Which lot each strategy should sell first, the
+ * slow and obvious way
+ *******************************************/
+bool sellsBefore(const Lot & lhs, const Lot & rhs, Fifo *)
+{
+   return lhs.seq < rhs.seq;
+}
+bool sellsBefore(const Lot & lhs, const Lot & rhs, Lifo *)
+{
+   return lhs.seq > rhs.seq;
+}
+bool sellsBefore(const Lot & lhs, const Lot & rhs, Hifo *)
+{
+   return lhs.price > rhs.price || (lhs.price == rhs.price && lhs.seq < rhs.seq);
+}
+bool sellsBefore(const Lot & lhs, const Lot & rhs, SpecificLot *)
+{
+   return lhs.seq < rhs.seq;
+}
+bool sellsBefore(const Lot & lhs, const Lot & rhs, SharedFifo *)
+{
+   return lhs.seq < rhs.seq;
+}
+
+/*******************************************
+ * MERGES
+ * Does the book add a lot to the newest one when
+ * they have the same price?
+ *******************************************/
+bool merges(Fifo *)        { return true;  }
+bool merges(Lifo *)        { return true;  }
+bool merges(Hifo *)        { return false; }
+bool merges(SpecificLot *) { return false; }
+bool merges(SharedFifo *)  { return true;  }
+
+/*******************************************
+ * TEST LOT BOOK
+ * Each book against a vector of lots searched from
+ * end to end for the one to sell
+ *******************************************/
+template <class Strategy>
+void testLotBook(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   LotBook <Strategy> book;
+   vector <Lot> lots;
+   int nextSeq = 0;
+
+   for (long step = 0; step < operations; step++)
+   {
+      if (random() % 100 < 50)
+      {
+         Dollars price = (!lots.empty() && random() % 4 == 0) ?
+                         lots.back().price : Dollars((int)(random() % 100));
+         Lot lot(random() % 500 + 1, price, nextSeq++);
+         book.push(lot);
+         if (merges((Strategy *)NULL) && !lots.empty() &&
+             lots.back().price == price)
+            lots.back().shares += lot.shares;
+         else
+            lots.push_back(lot);
+      }
+      else
+      {
+         // the lots the model expects to be sold, in order
+         int shares = random() % 1000 + 1;
+         vector <Lot> expected;
+         for (int left = shares; left > 0 && !lots.empty(); )
+         {
+            size_t first = 0;
+            for (size_t i = 1; i < lots.size(); i++)
+               if (sellsBefore(lots[i], lots[first], (Strategy *)NULL))
+                  first = i;
+            int take = lots[first].shares < left ? lots[first].shares : left;
+            expected.push_back(Lot(take, lots[first].price, lots[first].seq));
+            left -= take;
+            if ((lots[first].shares -= take) == 0)
+               lots.erase(lots.begin() + first);
+         }
+
+         size_t fill = 0;
+         sellLots(book, shares, [&](const Lot & lot, int take)
+         {
+            CHECK(fill < expected.size(), step);
+            CHECK(lot.seq == expected[fill].seq, step);
+            CHECK(take == expected[fill].shares, step);
+            fill++;
+         });
+         CHECK(fill == expected.size(), step);
+      }
+
+      CHECK(book.size() == (int)lots.size(), step);
+   }
+}
+
+/*******************************************
+ * TEST SPECIFIC LOT
+ * Selling from named lots, some of which are gone,
+ * including lots with sequence ids near INT_MAX
+ *******************************************/
+void testSpecificLot(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   LotBook <SpecificLot> book;
+   vector <int> shares;     // shares left in each lot by sequence id
+
+   for (long step = 0; step < operations; step++)
+   {
+      if (random() % 100 < 50)
+      {
+         shares.push_back(random() % 500 + 1);
+         book.push(Lot(shares.back(), Dollars(100), (int)shares.size() - 1));
+      }
+      else if (!shares.empty())
+      {
+         int seq = random() % shares.size();
+         int want = random() % 300 + 1;
+         int expected = shares[seq] < want ? shares[seq] : want;
+         int sold = sellLot(book, seq, want, [](const Lot &, int) {});
+         CHECK(sold == expected, step);
+         shares[seq] -= sold;
+         CHECK(book.contains(seq) == (shares[seq] > 0), step);
+      }
+   }
+
+   // the index only holds open lots, so a book that has made two
+   // billion buys costs no more than one that has made a few
+   LotBook <SpecificLot> late;
+   late.push(Lot(10, Dollars(100), INT_MAX - 1));
+   late.push(Lot(20, Dollars(100), INT_MAX - 2));
+   CHECK(late.next().seq == INT_MAX - 2, operations);
+   CHECK(sellLot(late, INT_MAX - 1, 10, [](const Lot &, int) {}) == 10,
+         operations);
+   CHECK(!late.contains(INT_MAX - 1) && late.contains(INT_MAX - 2),
+         operations);
+}
+
+/*******************************************
+ * SAME
+ * The same check for a CowQueue, which can be
+ * walked without changing it
+ *******************************************/
+void same(const CowQueue <int> & q, const deque <int> & d, long step)
+{
+   CHECK(q.size() == (int)d.size(), step);
+   CHECK(q.empty() == d.empty(), step);
+   for (size_t i = 0; i < d.size(); i++)
+      CHECK(q[(int)i] == d[i], step);
+}
+
+/*******************************************
+ * TEST COW QUEUE
+ * A CowQueue against a deque while snapshots are taken
+ * and dropped. Every snapshot must still hold exactly
+ * what it held when it was taken
+ *******************************************/
+void testCowQueue(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   CowQueue <int> q;
+   deque <int> d;
+   vector <CowQueue <int> > snapshots;
+   vector <deque <int> > expected;
+
+   for (long step = 0; step < operations; step++)
+   {
+      int op = random() % 100;
+      if (op < 45)
+      {
+         // bursts long enough to fill whole segments
+         int count = (random() % 4 == 0) ? random() % 600 : 1;
+         for (int i = 0; i < count; i++)
+         {
+            int value = (int)random();
+            q.push(value);
+            d.push_back(value);
+         }
+      }
+      else if (op < 70)
+      {
+         if (d.empty())
+         {
+            CHECK(throws([&]() { q.pop(); }), step);
+         }
+         int count = (random() % 4 == 0) ? random() % 600 : 1;
+         for (int i = 0; i < count && !d.empty(); i++)
+         {
+            q.pop();
+            d.pop_front();
+         }
+      }
+      else if (op < 78)
+      {
+         if (d.empty())
+         {
+            CHECK(throws([&]() { q.popBack(); }), step);
+         }
+         else
+         {
+            q.popBack();
+            d.pop_back();
+         }
+      }
+      else if (op < 86)
+      {
+         // change items in place, which must not show in a snapshot
+         if (!d.empty())
+         {
+            q.front() += 1;
+            d.front() += 1;
+            q.back() -= 1;
+            d.back() -= 1;
+         }
+      }
+      else if (op < 94)
+      {
+         CowQueue <int> snapshot(q);
+         CHECK(q.shared() && snapshot.shared(), step);
+         if (snapshots.size() < 4)
+         {
+            snapshots.push_back(snapshot);
+            expected.push_back(d);
+         }
+         else
+         {
+            int i = random() % snapshots.size();
+            snapshots[i] = snapshot;
+            expected[i] = d;
+         }
+      }
+      else if (op < 98)
+      {
+         if (!snapshots.empty())
+         {
+            snapshots.pop_back();
+            expected.pop_back();
+         }
+      }
+      else
+      {
+         q.clear();
+         d.clear();
+         CHECK(!q.shared(), step);
+      }
+
+      CHECK(q.size() == (int)d.size(), step);
+      if (!d.empty())
+      {
+         const CowQueue <int> & reader = q;
+         CHECK(reader.front() == d.front(), step);
+         CHECK(reader.back() == d.back(), step);
+      }
+      if (step % 100 == 0)
+         same(q, d, step);
+      if (!snapshots.empty() && step % 10 == 0)
+      {
+         int i = random() % snapshots.size();
+         same(snapshots[i], expected[i], step);
+      }
+   }
+}
+
+/*******************************************
+ * TEST SHM QUEUE
+ * A child process pushes numbered lots while this one
+ * pops them, letting go of the segment and attaching
+ * again now and then as a restarted consumer would
+ *******************************************/
+void testShmQueue(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   string name = "/queueTest." + to_string(getpid());
+   ShmQueue <Lot> * q = new ShmQueue <Lot> (name.c_str(),
+                                            ShmQueue <Lot> ::CREATE,
+                                            random() % 100 + 1);
+
+   pid_t child = fork();
+   if (child == 0)
+   {
+      ShmQueue <Lot> producer(name.c_str(), ShmQueue <Lot> ::ATTACH);
+      for (long i = 0; i < operations; i++)
+         while (!producer.push(Lot(1, Dollars((int)i), (int)i)))
+            sched_yield();
+      _exit(0);
+   }
+
+   try
+   {
+      for (long i = 0; i < operations; i++)
+      {
+         if (random() % 1000 == 0)
+         {
+            delete q;
+            q = new ShmQueue <Lot> (name.c_str(), ShmQueue <Lot> ::ATTACH);
+         }
+         Lot lot;
+         if (i % 2)
+         {
+            while (q->empty())
+               sched_yield();
+            CHECK(q->size() <= q->capacity(), i);
+            lot = q->front();
+            q->pop();
+         }
+         else
+         {
+            while (!q->tryPop(lot))
+               sched_yield();
+         }
+         CHECK(lot.seq == i && lot.price == Dollars((int)i), i);
+      }
+      CHECK(q->empty(), operations);
+   }
+   catch (...)
+   {
+      kill(child, SIGKILL);
+      waitpid(child, NULL, 0);
+      delete q;
+      ShmQueue <Lot> ::remove(name.c_str());
+      throw;
+   }
+
+   waitpid(child, NULL, 0);
+   delete q;
+   ShmQueue <Lot> ::remove(name.c_str());
+}
+
+/*******************************************
+ * KILL SOON
+ * Let a child run a random little while, then kill it
+ * wherever it is
+ *******************************************/
+void killSoon(mt19937 & random, pid_t child)
+{
+   usleep(random() % 2000);
+   kill(child, SIGKILL);
+   waitpid(child, NULL, 0);
+}
+
+/*******************************************
+ * TEST SHM CRASH
+ * Producers and consumers killed part way through, and
+ * segments left by creators that died or are still at
+ * work, or holding some other type
+ *******************************************/
+void testShmCrash(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   string name = "/queueTest." + to_string(getpid());
+   ShmQueue <Lot> ::remove(name.c_str());
+
+   try
+   {
+      // a producer killed mid-push: what is there is whole and in order
+      ShmQueue <Lot> q(name.c_str(), ShmQueue <Lot> ::CREATE,
+                       random() % 100 + 1);
+      pid_t child = fork();
+      if (child == 0)
+      {
+         ShmQueue <Lot> producer(name.c_str(), ShmQueue <Lot> ::ATTACH);
+         for (int i = 0; ; i++)
+            while (!producer.push(Lot(1, Dollars(i), i)))
+               ;
+      }
+      int next = 0;
+      Lot lot;
+      for (int i = random() % 1000; i > 0; i--)
+         if (q.tryPop(lot))
+            CHECK(lot.seq == next++, next);
+      killSoon(random, child);
+      while (q.tryPop(lot))
+         CHECK(lot.seq == next++ && lot.price == Dollars(lot.seq), next);
+
+      // a consumer killed mid-pop: what is left follows on from it
+      child = fork();
+      if (child == 0)
+      {
+         ShmQueue <Lot> consumer(name.c_str(), ShmQueue <Lot> ::OPEN);
+         for (;;)
+            consumer.tryPop(lot);
+      }
+      int pushed = next;
+      for (long i = 0; i < operations / 100; i++)
+         if (q.push(Lot(1, Dollars(pushed), pushed)))
+            pushed++;
+      killSoon(random, child);
+      if (q.tryPop(lot))
+      {
+         CHECK(lot.seq >= next && lot.seq < pushed, lot.seq);
+         next = lot.seq + 1;
+         while (q.tryPop(lot))
+            CHECK(lot.seq == next++, next);
+         CHECK(next == pushed, next);
+      }
+
+      // a queue of another type is never taken over
+      CHECK(throws([&]()
+      {
+         ShmQueue <int> other(name.c_str(), ShmQueue <int> ::OPEN);
+      }), 0);
+      CHECK(throws([&]()
+      {
+         ShmQueue <int> other(name.c_str(), ShmQueue <int> ::CREATE);
+      }), 0);
+      CHECK(q.push(Lot(1, Dollars(7), 7)) && q.tryPop(lot) && lot.seq == 7,
+            0);
+   }
+   catch (...)
+   {
+      ShmQueue <Lot> ::remove(name.c_str());
+      throw;
+   }
+   ShmQueue <Lot> ::remove(name.c_str());
+
+   // a segment someone is still setting up is left alone
+   int creator = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+   CHECK(creator >= 0 && flock(creator, LOCK_EX) == 0, 1);
+   CHECK(throws([&]()
+   {
+      ShmQueue <Lot> q(name.c_str(), ShmQueue <Lot> ::OPEN);
+   }), 1);
+   CHECK(throws([&]()
+   {
+      ShmQueue <Lot> q(name.c_str(), ShmQueue <Lot> ::CREATE);
+   }), 1);
+   int still = shm_open(name.c_str(), O_RDWR, 0600);
+   CHECK(still >= 0, 1);
+   close(still);
+
+   // and one whose creator died before it was ready is started over
+   CHECK(ftruncate(creator, 4096) == 0, 2);
+   close(creator);
+   {
+      ShmQueue <Lot> q(name.c_str(), ShmQueue <Lot> ::OPEN, 4);
+      CHECK(q.empty() && q.capacity() == 4, 2);
+   }
+   ShmQueue <Lot> ::remove(name.c_str());
+}
+
+/*******************************************
+ * BLOCK
+ * An item big enough that a LargeQueue of them fills
+ * its first 2MB after 128 pushes and grows often
+ *******************************************/
+struct Block
+{
+   long long seq;
+   char pad[16384 - sizeof(long long)];
+};
+
+/*******************************************
+ * TEST LARGE QUEUE
+ * Against a deque of sequence numbers, pushed in bursts
+ * so the ring grows while it has wrapped around. Every
+ * kind of page is tried, bound to node 0 or not at all
+ *******************************************/
+void testLargeQueue(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   LargeQueue <Block> ::Pages pages =
+      (LargeQueue <Block> ::Pages)(random() % 3);
+   LargeQueue <Block> q(random() % 2 ? 0 : 1, pages,
+                        random() % 2 ? -1 : 0);
+   deque <long long> d;
+   Block block;
+   memset(&block, 0, sizeof(block));
+
+   for (long step = 0; step < operations; step++)
+   {
+      int op = random() % 100;
+      if (op < 50)
+      {
+         int count = (random() % 8 == 0) ? random() % 200 : 1;
+         for (int i = 0; i < count; i++)
+         {
+            block.seq = step * 1000 + i;
+            block.pad[block.seq % sizeof(block.pad)] = (char)block.seq;
+            q.push(block);
+            d.push_back(block.seq);
+         }
+      }
+      else if (op < 90)
+      {
+         CHECK(q.tryPop(block) == !d.empty(), step);
+         if (!d.empty())
+         {
+            CHECK(block.seq == d.front(), step);
+            CHECK(block.pad[block.seq % sizeof(block.pad)] ==
+                  (char)block.seq, step);
+            d.pop_front();
+         }
+      }
+      else if (op < 95)
+      {
+         if (d.empty())
+            CHECK(throws([&]() { q.popBack(); }), step);
+         else
+         {
+            q.popBack();
+            d.pop_back();
+         }
+      }
+      else if (op < 99)
+      {
+         if (d.empty())
+            CHECK(throws([&]() { q.pop(); }), step);
+         else
+         {
+            q.pop();
+            d.pop_front();
+         }
+      }
+      else
+      {
+         q.clear();
+         d.clear();
+      }
+
+      CHECK(q.size() == d.size() && q.size() <= q.capacity(), step);
+      if (!d.empty())
+         CHECK(q.front().seq == d.front() && q.back().seq == d.back(),
+               step);
+   }
+   CHECK(q.getPages() != LargeQueue <Block> ::EXPLICIT ||
+         pages == LargeQueue <Block> ::EXPLICIT, operations);
+}
+
+/*******************************************
+ * TEST WORK DEQUE
+ * First alone against a deque, where popBack() is the
+ * back and steal() is the front. Then the owner pushes
+ * and pops while thieves steal on other threads: every
+ * item must be taken exactly once. A tiny starting
+ * capacity makes it grow while they are stealing
+ *******************************************/
+void testWorkDeque(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   {
+      WorkDeque <int> alone(1);
+      deque <int> expected;
+      for (long step = 0; step < operations; step++)
+      {
+         int item;
+         switch (random() % 4)
+         {
+            case 0:
+            case 1:
+               alone.push((int)step);
+               expected.push_back((int)step);
+               break;
+            case 2:
+               CHECK(alone.popBack(item) == !expected.empty(), step);
+               if (!expected.empty())
+               {
+                  CHECK(item == expected.back(), step);
+                  expected.pop_back();
+               }
+               break;
+            default:
+               CHECK(alone.steal(item) == !expected.empty(), step);
+               if (!expected.empty())
+               {
+                  CHECK(item == expected.front(), step);
+                  expected.pop_front();
+               }
+               break;
+         }
+         CHECK(alone.size() == (int)expected.size(), step);
+         CHECK(alone.size() <= alone.capacity(), step);
+      }
+   }
+
+   const int THIEVES = 3;
+   WorkDeque <int> shared(2);
+   vector <int> taken[THIEVES + 1];
+   atomic <bool> done(false);
+   vector <thread> thieves;
+   for (int i = 0; i < THIEVES; i++)
+      thieves.push_back(thread([&, i]()
+      {
+         int item;
+         while (!done.load())
+            if (shared.steal(item))
+               taken[i].push_back(item);
+            else
+               this_thread::yield();
+      }));
+
+   int item;
+   for (long step = 0; step < operations; step++)
+   {
+      shared.push((int)step);
+      if (random() % 3 == 0 && shared.popBack(item))
+         taken[THIEVES].push_back(item);
+   }
+   while (shared.popBack(item))
+      taken[THIEVES].push_back(item);
+   done = true;
+   for (int i = 0; i < THIEVES; i++)
+      thieves[i].join();
+
+   vector <int> times(operations, 0);
+   for (int i = 0; i <= THIEVES; i++)
+      for (size_t j = 0; j < taken[i].size(); j++)
+         times[taken[i][j]]++;
+   for (long step = 0; step < operations; step++)
+      CHECK(times[step] == 1, step);
+}
+
+/*******************************************
+ * TEST ORDER BOOK
+ * The flat book against a std::map book on orders around
+ * a price that wanders, some off the book, with cancels
+ * of recent orders, of orders long gone, and of ids that
+ * were never given out. The fills must be the same, and
+ * so must what rests. The book's table of orders must
+ * stay near the most that ever rested at once
+ *******************************************/
+void testOrderBook(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   int levels = (int)(random() % 200) + 20;
+   int reference = 10000;
+   OrderBook book(Dollars(reference), 1, levels);
+   MapBook map;
+   vector <int> ids;             // the flat book's id for each order
+   unordered_map <int, int> numbers;   // and back again
+   Queue <Fill> fills;
+   vector <Fill> mapFills;
+   int mid = levels / 2;
+   int peak = 0;                 // the most orders ever resting
+
+   for (long step = 0; step < operations; step++)
+   {
+      if (!ids.empty() && random() % 100 < 60)
+      {
+         int number = (int)ids.size() - 1 -
+                      (int)(random() % min((int)ids.size(), 50));
+         if (random() % 20 == 0)
+            number = (int)(random() % ids.size());
+         CHECK(book.remaining(ids[number]) == map.remaining(number), step);
+         CHECK(book.cancel(ids[number]) == map.cancel(number), step);
+         CHECK(!book.cancel(ids[number]), step);
+      }
+      else
+      {
+         if (random() % 10 == 0)
+            mid += (int)(random() % 3) - 1;
+         mid = max(5, min(levels - 6, mid));
+         Order::Side side = (random() % 2 ? Order::BUY : Order::SELL);
+         int shares = (int)(random() % 100) + 1;
+         int level = mid + (int)(random() % 9) - 4;
+         if (random() % 50 == 0)
+            level = (random() % 2 ? -1 : levels);
+         int cents = reference + level;
+
+         int id = book.add(side, shares, Dollars(cents), fills);
+         if (level < 0 || level >= levels)
+         {
+            CHECK(id == -1 && fills.empty(), step);
+            continue;
+         }
+         CHECK(numbers.find(id) == numbers.end(), step);
+         numbers[id] = (int)ids.size();
+         ids.push_back(id);
+         map.add(side, shares, cents, mapFills);
+
+         CHECK(fills.size() == (int)mapFills.size(), step);
+         for (size_t i = 0; i < mapFills.size(); i++, fills.pop())
+            CHECK(numbers[fills.front().resting] == mapFills[i].resting &&
+                  numbers[fills.front().incoming] == mapFills[i].incoming &&
+                  fills.front().shares == mapFills[i].shares &&
+                  fills.front().price == mapFills[i].price, step);
+         mapFills.clear();
+      }
+
+      CHECK(book.size() == map.size(), step);
+      Dollars price;
+      int cents;
+      bool bid = book.bestBid(price);
+      CHECK(bid == map.bestBid(cents) && (!bid || price == Dollars(cents)),
+            step);
+      bool ask = book.bestAsk(price);
+      CHECK(ask == map.bestAsk(cents) && (!ask || price == Dollars(cents)),
+            step);
+      int level = (int)(random() % levels);
+      Order::Side side = (random() % 2 ? Order::BUY : Order::SELL);
+      CHECK(book.depth(side, Dollars(reference + level)) ==
+            map.depth(side, reference + level), step);
+      peak = max(peak, book.size());
+      CHECK(book.slots() <= peak + 1 +
+            (int)ids.size() / OrderBook::MAX_USES, step);
+   }
+
+   CHECK(book.remaining(-1) == 0 && !book.cancel(-1), operations);
+   CHECK(book.remaining(INT_MAX) == 0 && !book.cancel(INT_MAX), operations);
+}
+
+/*******************************************
+ * TEST PRICE WINDOW
+ * The window against a deque of trades that is
+ * searched end to end for every answer
+ *******************************************/
+void testPriceWindow(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   int maxTrades = (random() % 2 ? 0 : random() % 50 + 1);
+   PriceWindow window(maxTrades);
+   deque <Trade> d;
+   long long now = 0;
+
+   for (long step = 0; step < operations; step++)
+   {
+      if (random() % 10 < 7)
+      {
+         now += random() % 5;
+         Trade trade(now, random() % 1000 + 1, Dollars((int)(random() % 200)));
+         window.push(trade);
+         d.push_back(trade);
+         if (maxTrades && (int)d.size() > maxTrades)
+            d.pop_front();
+      }
+      else
+      {
+         long long since = now - random() % 100;
+         window.evictOlderThan(since);
+         while (!d.empty() && d.front().time < since)
+            d.pop_front();
+      }
+
+      CHECK(window.size() == (int)d.size(), step);
+      if (d.empty())
+      {
+         CHECK(throws([&]() { window.min(); }), step);
+         continue;
+      }
+
+      Dollars low = d.front().price;
+      Dollars high = d.front().price;
+      long long notional = 0;
+      long long volume = 0;
+      for (size_t i = 0; i < d.size(); i++)
+      {
+         if (d[i].price < low)
+            low = d[i].price;
+         if (d[i].price > high)
+            high = d[i].price;
+         notional += (long long)d[i].shares * d[i].price.getCents();
+         volume += d[i].shares;
+      }
+      CHECK(window.min() == low, step);
+      CHECK(window.max() == high, step);
+      CHECK(window.getVolume() == volume, step);
+      CHECK(window.vwap() == Dollars((int)((notional * 2 + volume) /
+                                           (volume * 2))), step);
+   }
+}
+
+/*******************************************
+ * TEST REPORT WRITER
+ * The writer against an ostringstream fed the same
+ * text, numbers, and Dollars, some of them padded. A
+ * small buffer makes it flush in the middle of a batch
+ * now and then. Writing to a socket nobody reads throws
+ *******************************************/
+void testReportWriter(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   int pipes[2];
+   if (pipe(pipes) != 0)
+      throw "ERROR: unable to make a pipe";
+   ReportWriter out(pipes[1], random() % 100 + 32);
+
+   const char * words[] = { "", "Proceeds: ", "\tSold ", " shares at ",
+      "a line long enough that it will not fit in the writer's buffer "
+      "all at once, so it has to go out in more than one piece" };
+   try
+   {
+      for (long step = 0; step < operations; step++)
+      {
+         ostringstream expected;
+         for (int i = random() % 10; i >= 0; i--)
+         {
+            // now and then a padded item, lined up on either side
+            int width = (random() % 4 ? 0 : (int)(random() % 20));
+            ReportWriter::Align align = (random() % 2 ? ReportWriter::RIGHT :
+                                                        ReportWriter::LEFT);
+            if (width)
+               out.width(width, align);
+
+            ostringstream item;
+            switch (random() % 6)
+            {
+               case 0:
+               {
+                  const char * word = words[random() % 5];
+                  out << word;
+                  item << word;
+                  break;
+               }
+               case 1:
+                  out << '\n';
+                  item << '\n';
+                  break;
+               case 2:
+               {
+                  int value = (random() % 50 ? (int)random() : INT_MIN);
+                  out << value;
+                  item << value;
+                  break;
+               }
+               case 3:
+               {
+                  unsigned long long bits =
+                     (unsigned long long)random() << 32 | random();
+                  long long value = (random() % 50 ? (long long)bits :
+                                     LLONG_MIN);
+                  out << value;
+                  item << value;
+                  break;
+               }
+               default:
+               {
+                  Dollars value = (random() % 50 ?
+                                   Dollars((int)(random() % 200001) - 100000) :
+                                   Dollars(INT_MIN));
+                  out << value;
+                  item << value;
+                  break;
+               }
+            }
+            string text = item.str();
+            if ((int)text.size() < width)
+               text.insert(align == ReportWriter::RIGHT ? 0 : text.size(),
+                           width - text.size(), ' ');
+            expected << text;
+         }
+         CHECK(out.size() <= out.capacity(), step);
+         out.flush();
+         CHECK(out.size() == 0, step);
+
+         string text = expected.str();
+         string written(text.size(), '\0');
+         size_t done = 0;
+         while (done < text.size())
+         {
+            ssize_t count = read(pipes[0], &written[done], text.size() - done);
+            CHECK(count > 0, step);
+            done += count;
+         }
+         CHECK(written == text, step);
+      }
+
+      // a NON_BLOCKING writer grows past what the pipe will take, and
+      // hands it over a piece at a time as the reader makes room
+      fcntl(pipes[1], F_SETFL, O_NONBLOCK);
+      ReportWriter later(pipes[1], 32, ReportWriter::NON_BLOCKING);
+      string text;
+      while (text.size() < 200000)
+      {
+         const char * word = words[random() % 5];
+         later << word;
+         text += word;
+      }
+      CHECK(later.size() == (int)text.size(), 0);
+      CHECK(!later.flushSome(), 0);
+
+      string written;
+      char piece[4096];
+      while (written.size() < text.size())
+      {
+         later.flushSome();
+         ssize_t count = read(pipes[0], piece, sizeof(piece));
+         CHECK(count > 0, (long)written.size());
+         written.append(piece, count);
+      }
+      CHECK(later.size() == 0, 0);
+      CHECK(written == text, 0);
+   }
+   catch (...)
+   {
+      close(pipes[0]);
+      close(pipes[1]);
+      throw;
+   }
+   close(pipes[0]);
+   close(pipes[1]);
+
+   // a socket whose reader hung up is an error to throw, not a SIGPIPE
+   int ends[2];
+   if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0)
+      throw "ERROR: unable to make a socket pair";
+   close(ends[1]);
+   bool failed;
+   {
+      ReportWriter gone(ends[0], 32);
+      gone << "nobody is listening\n";
+      failed = throws([&]() { gone.flush(); });
+   }
+   close(ends[0]);
+   CHECK(failed, 0);
+}
+
+/*******************************************
+ * SAME
+ * Do two portfolios hold the same lots, sales, and totals?
+ * They need not keep them in the same kind of book
+ *******************************************/
+template <class Left, class Right>
+void same(const BasicPortfolio <Left> & lhs,
+          const BasicPortfolio <Right> & rhs, long step)
+{
+   CHECK(lhs.getShares()    == rhs.getShares(),    step);
+   CHECK(lhs.getCostBasis() == rhs.getCostBasis(), step);
+   CHECK(lhs.getLotsValue() == lhs.getCostBasis() &&
+         rhs.getLotsValue() == rhs.getCostBasis(), step);
+   CHECK(lhs.getLastPrice() == rhs.getLastPrice(), step);
+   CHECK(lhs.getProceeds()  == rhs.getProceeds(),  step);
+
+   Queue <Event> left;
+   Queue <Event> right;
+   lhs.reportLots(left);
+   rhs.reportLots(right);
+   CHECK(left.size() == right.size(), step);
+   Event l;
+   Event r;
+   while (left.tryPop(l) && right.tryPop(r))
+      CHECK(l.kind == r.kind && l.shares == r.shares &&
+            l.price == r.price && l.amount == r.amount, step);
+}
+
+/*******************************************
+ * ROUND TRIP
+ * Formatting then parsing gives back the same units
+ *******************************************/
+template <int Scale>
+bool roundTrip(long long units)
+{
+   FixedPoint <Scale> value = FixedPoint <Scale> ::fromUnits(units);
+   char text[FixedPoint <Scale> ::MAX_TEXT];
+   int length = value.format(text);
+   FixedPoint <Scale> parsed;
+   return FixedPoint <Scale> ::parse(text, text + length, parsed) ==
+             text + length && parsed == value;
+}
+
+/*******************************************
+ * TEST FIXED POINT
+ * Two decimal places against Dollars on the same text,
+ * every scale through its own text and back, and text
+ * with far too many digits, which has to stop at the
+ * largest amount rather than overflow
+ *******************************************/
+void testFixedPoint(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   const char * before[] = { "", " ", "$", "-", "(", "$-", "$(", "\t$(" };
+   for (long step = 0; step < operations; step++)
+   {
+      string text = before[random() % 8] + to_string(random() % 20000000);
+      if (random() % 2)
+         text += "." + to_string(random() % 10) +
+                 (random() % 2 ? to_string(random() % 10) : "");
+      if (random() % 4 == 0)
+         text += ")";
+
+      Dollars dollars;
+      FixedPoint <2> fixed;
+      const char * end = text.data() + text.size();
+      CHECK(Dollars::parse(text.data(), end, dollars) ==
+            FixedPoint <2> ::parse(text.data(), end, fixed), step);
+      CHECK(fixed.getUnits() == dollars.getCents(), step);
+      CHECK(fixed.toDollars() == dollars, step);
+
+      long long units = (long long)(random() % 2 ? random() : 0) << 32 |
+                        random();
+      units = (random() % 2 ? -units : units);
+      CHECK(roundTrip <0> (units) && roundTrip <2> (units) &&
+            roundTrip <4> (units) && roundTrip <18> (units), step);
+   }
+   CHECK(roundTrip <4> (LLONG_MAX) && roundTrip <4> (-LLONG_MAX), 0);
+
+   // too many digits stop at the largest amount
+   string digits(40, '9');
+   FixedPoint <4> big;
+   FixedPoint <4> ::parse(digits.data(), digits.data() + digits.size(), big);
+   CHECK(big.getUnits() == LLONG_MAX, 1);
+   digits = "(" + digits + ".99999)";
+   FixedPoint <18> small;
+   FixedPoint <18> ::parse(digits.data(), digits.data() + digits.size(),
+                           small);
+   CHECK(small.getUnits() == -LLONG_MAX, 2);
+
+   // and what does not fit in fewer places or in Dollars is an error
+   CHECK(throws([&]() { big.toDollars(); }), 3);
+   CHECK(throws([&]() { FixedPoint <18> wide(Dollars(INT_MAX)); }), 4);
+   CHECK(FixedPoint <2> ::fromUnits(INT_MAX).toDollars() == Dollars(INT_MAX),
+         5);
+}
+
+/*******************************************
+ * TEST PORTFOLIO TOTALS
+ * Totals far past what int cents can hold, against
+ * the same sums in long long, and a sell of nothing
+ *******************************************/
+void testPortfolioTotals(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   Portfolio portfolio;
+   Queue <Event> events;
+
+   // with nothing held, a sell is not a trade and sets no price
+   portfolio.sell(100, Dollars(500));
+   CHECK(portfolio.getLastPrice() == Dollars(), 0);
+   CHECK(portfolio.getShares() == 0, 0);
+
+   long long basis = 0;
+   long long proceeds = 0;
+   Queue <Lot> lots;
+   for (long step = 0; step < operations; step++)
+   {
+      int shares = (int)(random() % 1000000) + 1;
+      int cents = (int)(random() % 100000) + 1;
+      if (random() % 3)
+      {
+         portfolio.buy(shares, Dollars(cents));
+         lots.push(Lot(shares, Dollars(cents), 0));
+         basis += (long long)shares * cents;
+      }
+      else
+      {
+         int sold = portfolio.sell(shares, Dollars(cents));
+         for (int left = sold; left > 0; )
+         {
+            int take = min(left, lots.front().shares);
+            basis -= (long long)take * lots.front().price.getCents();
+            proceeds += (long long)take *
+                        (cents - lots.front().price.getCents());
+            left -= take;
+            if ((lots.front().shares -= take) == 0)
+               lots.pop();
+         }
+      }
+      CHECK(portfolio.getCostBasis().getUnits() == basis, step);
+      CHECK(portfolio.getProceeds().getUnits() == proceeds, step);
+      CHECK(portfolio.getLotsValue().getUnits() == basis, step);
+   }
+
+   // and the report shows them whole
+   portfolio.report(events);
+   ostringstream text;
+   for (Event event; events.tryPop(event); )
+      text << event;
+   char basisText[Total::MAX_TEXT];
+   string expected(basisText, portfolio.getCostBasis().format(basisText));
+   CHECK(text.str().find("cost basis of " + expected + '\n') !=
+         string::npos, operations);
+}
+
+/*******************************************
+ * SYMBOL OF
+ * The id a history gave a command's ticker
+ *******************************************/
+uint32_t symbolOf(const PortfolioHistory & history, const Command & command)
+{
+   const char * ticker = (command.ticker[0] ? command.ticker :
+                                              PortfolioHistory::UNNAMED);
+   return history.getSymbols().find(ticker, strlen(ticker));
+}
+
+/*******************************************
+ * TEST PORTFOLIO HISTORY
+ * A point in time query against replaying every
+ * trade from the start. Some histories keep all of
+ * their trades, some only the last few or none.
+ * Some trade several symbols and some only one
+ *******************************************/
+void testPortfolioHistory(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   int interval = random() % 20 + 1;
+   int kept = (random() % 3 == 0 ? (int)(random() % 100) :
+                                   PortfolioHistory::KEEP_TRADES);
+   PortfolioHistory history(interval, kept);
+   vector <Command> trades;
+   Queue <Event> events;
+   const char * tickers[] = { "", "ACME", "BRK.B", "X" };
+   int named = (random() % 2 ? 4 : 1);
+
+   for (long step = 0; step < operations; step++)
+   {
+      Command command;
+      command.type = (random() % 2 ? Command::BUY : Command::SELL);
+      command.shares = random() % 300 + 1;
+      command.price = Dollars((int)(random() % 1000 + 1));
+      strcpy(command.ticker, tickers[random() % named]);
+      history.apply(command, events);
+      trades.push_back(command);
+      events.clear();
+      CHECK(history.getTrades() == (int)trades.size(), step);
+
+      // the journal has the trade, with its ticker interned
+      if (kept > 0)
+      {
+         const TradeRecord & record = history.getRecord(history.getTrades());
+         const SymbolTable & symbols = history.getSymbols();
+         CHECK(symbols.name(record.symbol) == (command.ticker[0] ?
+               command.ticker : PortfolioHistory::UNNAMED), step);
+         CHECK(record.shares == command.shares &&
+               record.price == command.price &&
+               record.isBuy() == (command.type == Command::BUY), step);
+      }
+      CHECK(history.getOldest() % interval == 0 || kept == 0, step);
+      CHECK(history.getTrades() - history.getOldest() < kept + interval,
+            step);
+      CHECK(history.getTrades() - history.getOldest() >=
+            min(kept, history.getTrades()), step);
+
+      if (random() % 10 == 0)
+      {
+         int trade = random() % (trades.size() + 1);
+         if (trade < history.getOldest())
+         {
+            CHECK(throws([&]() { history.asOf(trade); }), step);
+            continue;
+         }
+         Portfolio replayed;
+         for (int i = 0; i < trade; i++)
+            replayed.apply(trades[i], events, symbolOf(history, trades[i]));
+         events.clear();
+         same(history.asOf(trade), replayed, step);
+      }
+   }
+   same(history.asOf(history.getTrades()), history.current(), operations);
+   CHECK(throws([&]() { history.asOf(history.getTrades() + 1); }),
+         operations);
+   CHECK(throws([&]() { history.getRecord(history.getOldest()); }),
+         operations);
+   CHECK(history.getSymbols().find(PortfolioHistory::UNNAMED,
+         strlen(PortfolioHistory::UNNAMED)) == 0, operations);
+
+   // a lots report is a snapshot, which stays as it was
+   history.apply(parseCommand("lots"), events);
+   Event event;
+   CHECK(events.tryPop(event) && event.getSnapshot() != NULL, operations);
+   history.apply(parseCommand("buy 5 $1.00"), events);
+   events.clear();
+   Portfolio replayed;
+   for (size_t i = 0; i < trades.size(); i++)
+      replayed.apply(trades[i], events, symbolOf(history, trades[i]));
+   events.clear();
+   same(*event.getSnapshot(), replayed, operations);
+
+   // the encoding has no tickers to match named trades by
+   if (history.getOldest() > 0 || history.getSymbols().size() > 1)
+   {
+      CHECK(throws([&]() { history.exportJournal(); }), operations);
+      return;
+   }
+
+   // the journal makes the same portfolio somewhere else
+   PortfolioHistory restored;
+   restored.importJournal(history.exportJournal());
+   CHECK(restored.getTrades() == history.getTrades(), operations);
+   same(restored.current(), history.current(), operations);
+}
+
+/*******************************************
+ * TEST SYMBOLS
+ * A sell only draws on lots of its own symbol. Random
+ * trades in three symbols through one history must
+ * leave each one as a portfolio of its own would
+ *******************************************/
+void testSymbols(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   PortfolioHistory history;
+   Queue <Event> events;
+   const SnapshotPortfolio & now = history.current();
+
+   // selling ACME does not sell the XYZ we hold
+   history.apply(parseCommand("buy 100 $1.00 XYZ"), events);
+   history.apply(parseCommand("sell 50 $2.00 ACME"), events);
+   uint32_t xyz = history.getSymbols().find("XYZ");
+   uint32_t acme = history.getSymbols().find("ACME");
+   CHECK(now.getShares(xyz) == 100 && now.getShares(acme) == 0 &&
+         now.getProceeds() == Total(), 0);
+
+   history.apply(parseCommand("buy 10 $3.00"), events);
+   history.apply(parseCommand("sell 50 $2.00 XYZ"), events);
+   CHECK(now.getShares(xyz) == 50 && now.getShares(0) == 10 &&
+         now.getProceeds() == Total(Dollars(5000)), 1);
+   CHECK(history.asOf(2).getShares(xyz) == 100, 2);
+
+   // and each symbol is worth what it last traded for
+   events.clear();
+   history.apply(parseCommand("display"), events);
+   ostringstream text;
+   for (Event event; events.tryPop(event); )
+      text << event;
+   CHECK(text.str() ==
+         "Holding 60 shares with a cost basis of $80.00\n"
+         "Worth $30.00 at $3.00 for an unrealized profit of $0.00\n"
+         "Worth $100.00 at $2.00 for an unrealized profit of $50.00\n"
+         "Proceeds: $50.00\n", 3);
+
+   // random trades, each also made in its own symbol's portfolio
+   const char * tickers[] = { "", "XYZ", "ACME" };
+   uint32_t ids[] = { 0, xyz, acme };
+   Portfolio alone[3];
+   alone[0].buy(10, Dollars(300));
+   alone[1].buy(100, Dollars(100));
+   alone[1].sell(50, Dollars(200));
+
+   for (long step = 0; step < operations; step++)
+   {
+      int which = (int)(random() % 3);
+      string line = string(random() % 2 ? "buy " : "sell ") +
+                    to_string(random() % 300 + 1) + " $" +
+                    to_string(random() % 9 + 1) + ".00 " + tickers[which];
+      Command command = parseCommand(line);
+      history.apply(command, events);
+      alone[which].apply(command, events);
+      events.clear();
+
+      Total basis;
+      Total proceeds;
+      Total value;
+      for (int i = 0; i < 3; i++)
+      {
+         CHECK(now.getShares(ids[i]) == alone[i].getShares(), step);
+         basis += alone[i].getCostBasis();
+         proceeds += alone[i].getProceeds();
+         value += alone[i].getMarketValue();
+      }
+      CHECK(now.getCostBasis() == basis && now.getProceeds() == proceeds &&
+            now.getMarketValue() == value, step);
+      CHECK(now.getLotsValue() == basis, step);
+   }
+}
+
+/*******************************************
+ * TEST JOURNAL CODEC
+ * Rows that mostly wander a little, with the odd jump
+ * to the ends of an int, through blocks of a random
+ * size. They must come back the same read in pieces
+ * of any size and from any row. A damaged copy must
+ * be turned away or read, never read out of bounds
+ *******************************************/
+void testJournalCodec(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   JournalEncoder encoder(random() % 300 + 1);
+   vector <JournalRow> rows;
+   JournalRow row(0, 100, 1000, 0);
+   for (long step = 0; step < operations; step++)
+   {
+      row.kind = random() % 3;
+      row.shares += (int)(random() % 21) - 10;
+      row.cents += (int)(random() % 11) - 5;
+      row.seq += (int)(random() % 3);
+      JournalRow added = row;
+      if (random() % 100 == 0)
+      {
+         int extremes[] = { INT_MIN, INT_MAX, 0, -1 };
+         added.cents = extremes[random() % 4];
+         added.kind = extremes[random() % 4];
+      }
+      encoder.add(added);
+      rows.push_back(added);
+   }
+   string encoding = encoder.finish();
+   CHECK(encoding == encoder.finish(), operations);
+
+   JournalDecoder decoder(encoding.data(), encoding.size());
+   CHECK(decoder.getRows() == (long long)rows.size(), 0);
+   JournalRow read[500];
+   for (int seeks = 0; seeks < 20; seeks++)
+   {
+      long start = random() % (rows.size() + 1);
+      decoder.seek(start);
+      long at = start;
+      int count;
+      while ((count = decoder.next(read, random() % 500 + 1)) > 0)
+         for (int i = 0; i < count; i++, at++)
+            CHECK(at < (long)rows.size() &&
+                  read[i].kind   == rows[at].kind   &&
+                  read[i].shares == rows[at].shares &&
+                  read[i].cents  == rows[at].cents  &&
+                  read[i].seq    == rows[at].seq, at);
+      CHECK(at == (long)rows.size(), start);
+   }
+   CHECK(throws([&]() { decoder.seek((long long)rows.size() + 1); }), 0);
+
+   // lots go through a Queue and come back onto one
+   Queue <Lot> lots;
+   for (int i = 0; i < 1000 && i < (int)rows.size(); i++)
+      lots.push(Lot(rows[i].shares, Dollars(rows[i].cents), rows[i].seq));
+   Queue <Lot> restored;
+   decodeLots(encodeLots(lots), restored);
+   CHECK(restored.size() == lots.size(), 0);
+   for (Lot lot; restored.tryPop(lot); lots.pop())
+      CHECK(lot.shares == lots.front().shares &&
+            lot.price  == lots.front().price  &&
+            lot.seq    == lots.front().seq, lots.size());
+
+   for (int damage = 0; damage < 200; damage++)
+   {
+      string damaged = encoding;
+      size_t block = damaged.rfind("JBLK");
+      if (random() % 4 == 0)
+         damaged.resize(random() % damaged.size());
+      else if (random() % 3 == 0 && block != string::npos)
+         damaged[block + 4 + random() % 4] ^= (char)(1 << random() % 8);
+      else
+         damaged[random() % damaged.size()] ^= (char)(1 << random() % 8);
+      try
+      {
+         JournalDecoder bad(damaged.data(), damaged.size());
+         while (bad.next(read, 500) > 0)
+            ;
+      }
+      catch (const char *)
+      {
+      }
+   }
+}
+
+/*******************************************
+ * TEST PARSE COMMAND
+ * Parsing a line of text against reading the same
+ * line through a stream, followed by blank lines and
+ * a command with more after it on its line
+ *******************************************/
+void testParseCommand(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   const char * words[] = { "buy", "sell", "display", "lots", "asof",
+                            "quit", "stats", "bogus", "BUY", "buyx", "" };
+   const char * numbers[] = { "0", "-5", "+7", "007", "2147483647",
+                              "2147483648", "-2147483648", "99999999999",
+                              "5.5", "10abc", "-", "+", "x", "" };
+   const char * prices[] = { "$1.57", "(4.21)", "-3", "$$2", "1.999",
+                             "$(", "$-.5", "99999999999", "abc", "" };
+   const char * spaces[] = { " ", "  ", "\t", " \r", "" };
+   const char * tickers[] = { "ACME", "brk.b", "X", "9X", "ACME-W",
+                              "ABCDEFGHIJKLMNO", "ABCDEFGHIJKLMNOP", "" };
+
+   for (long step = 0; step < operations; step++)
+   {
+      string line = string(spaces[random() % 5]) + words[random() % 11] +
+                    spaces[random() % 5];
+      if (random() % 4)
+      {
+         if (random() % 3)
+            line += to_string((int)(random() % 1000) - 100);
+         else
+            line += numbers[random() % 14];
+         line += spaces[random() % 5];
+         line += prices[random() % 10];
+         if (random() % 2)
+         {
+            line += spaces[random() % 5];
+            line += tickers[random() % 8];
+         }
+      }
+
+      // the stream reader skips blank lines, and anything after the
+      // command on its line never becomes a command of its own
+      istringstream in(line + "\n\n \t\nbuy 10 $1.50 ACME extra\n");
+      bool blank = (line.find_first_not_of(" \t\r") == string::npos);
+      Command expected;
+      Command after;
+      if (!blank)
+         in >> expected;
+      in >> after;
+      CHECK(after.type == Command::BUY &&
+            strcmp(after.ticker, "ACME") == 0 && !(in >> after), step);
+      if (blank)
+         continue;
+      Command command = parseCommand(line);
+
+      CHECK(command.type == expected.type, step);
+      if (command.type == Command::BUY || command.type == Command::SELL)
+         CHECK(command.shares == expected.shares &&
+               command.price == expected.price &&
+               strcmp(command.ticker, expected.ticker) == 0, step);
+      if (command.type == Command::ASOF)
+         CHECK(command.shares == expected.shares, step);
+   }
+
+   // a ticker has to be a word of its own after the price
+   Command glued = parseCommand("buy 10 $1.5abc");
+   Command apart = parseCommand("buy 10 $1.5 abc");
+   CHECK(glued.type == Command::INVALID, operations);
+   CHECK(apart.type == Command::BUY && apart.price == Dollars(150) &&
+         strcmp(apart.ticker, "abc") == 0, operations);
+}
+
+/*******************************************
+ * WITHOUT PROMPTS
+ * A report with the instructions, the prompts, and the
+ * latency lines taken out, which leaves the events. The
+ * latency lines are timings, so no two runs agree on them
+ *******************************************/
+string withoutPrompts(const string & report)
+{
+   size_t start = report.find("> ");
+   istringstream in(report.substr(start == string::npos ? 0 : start));
+   string kept;
+   string line;
+   while (getline(in, line))
+   {
+      while (line.compare(0, 2, "> ") == 0)
+         line.erase(0, 2);
+      if (!line.empty() && line != "Latency by command:" &&
+          line.find(" commands, p50 ") == string::npos)
+         kept += line + '\n';
+   }
+   return kept;
+}
+
+/*******************************************
+ * TEMPORARY FILE
+ * An empty file, already unlinked so it goes away
+ * when it is closed
+ *******************************************/
+int temporaryFile()
+{
+   char path[] = "/tmp/queueTestXXXXXX";
+   int fd = mkstemp(path);
+   if (fd < 0)
+      throw "ERROR: Unable to make a temporary file";
+   unlink(path);
+   return fd;
+}
+
+/*******************************************
+ * CONTENTS
+ * Everything written to a temporary file, which is
+ * then closed
+ *******************************************/
+string contents(int fd)
+{
+   string text;
+   char buffer[4096];
+   lseek(fd, 0, SEEK_SET);
+   for (ssize_t got; (got = read(fd, buffer, sizeof(buffer))) > 0; )
+      text.append(buffer, got);
+   close(fd);
+   return text;
+}
+
+/*******************************************
+ * STOCK SCRIPT
+ * Commands for the stock program, one to a line, with
+ * blank lines and maybe a quit part way through
+ *******************************************/
+string stockScript(mt19937 & random, long commands)
+{
+   const char * words[] = { "buy", "sell", "display", "lots", "asof",
+                            "stats", "bogus" };
+   string script;
+   for (long i = 0; i < commands; i++)
+   {
+      int word = (int)(random() % 10);
+      if (word > 6)
+         word = (int)(random() % 2);
+      script += words[word];
+      if (word < 2)
+         script += ' ' + to_string(random() % 300 + 1) + " $" +
+                   to_string(random() % 5 + 1) + '.' +
+                   to_string(random() % 90 + 10);
+      else if (word == 4)
+         script += ' ' + to_string(random() % (i + 2));
+      script += (random() % 20 == 0 ? "\n\n" : "\n");
+   }
+   if (random() % 4 == 0)
+      script.insert(script.find('\n', random() % script.size()) + 1,
+                    "quit\n");
+   return script;
+}
+
+/*******************************************
+ * BUY SELL REPORT
+ * What stocksBuySell() writes for a script
+ *******************************************/
+string buySellReport(const string & script)
+{
+   int fd = temporaryFile();
+   {
+      istringstream in(script);
+      ReportWriter out(fd);
+      stocksBuySell(in, out);
+   }
+   return contents(fd);
+}
+
+/*******************************************
+ * TEST PIPELINE
+ * The three stage pipeline against stocksBuySell() on
+ * the same script
+ *******************************************/
+void testPipeline(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   string script = stockScript(random, operations);
+   string expected = buySellReport(script);
+
+   int fd = temporaryFile();
+   PipelineStats stats;
+   {
+      istringstream in(script);
+      ReportWriter out(fd);
+      stocksPipeline(in, out, stats);
+   }
+   string actual = contents(fd);
+
+   CHECK(withoutPrompts(actual) == withoutPrompts(expected), 0);
+   CHECK(stats.stages[PipelineStats::PARSE].items ==
+         stats.stages[PipelineStats::MATCH].items, 1);
+   CHECK(stats.stages[PipelineStats::PARSE].batches <=
+         stats.stages[PipelineStats::PARSE].items, 2);
+}
+
+/*******************************************
+ * TEST SERVER
+ * A client on a Unix socket sends a script a piece at
+ * a time and must get back what stocksBuySell() says
+ * to it. The script always ends with a quit, as the
+ * server gives no final report to a client that just
+ * hangs up. Then a client that hangs up without reading
+ * its answers must not take the server with it
+ *******************************************/
+void testServer(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   string script = stockScript(random, operations) + "quit\n";
+   string expected = buySellReport(script);
+
+   string path = "/tmp/queueTest." + to_string(getpid()) + ".sock";
+   StockServer server(path.c_str());
+   thread serving([&]() { server.run(); });
+
+   sockaddr_un name;
+   memset(&name, 0, sizeof(name));
+   name.sun_family = AF_UNIX;
+   strncpy(name.sun_path, path.c_str(), sizeof(name.sun_path) - 1);
+   string actual;
+   int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   bool connected = (fd >= 0 &&
+                     connect(fd, (sockaddr *)&name, sizeof(name)) == 0);
+   if (connected)
+   {
+      // the server stops reading after a quit, so the rest of the
+      // script may never be taken
+      thread sending([&]()
+      {
+         mt19937 pieces(seed);
+         for (size_t sent = 0; sent < script.size(); )
+         {
+            size_t piece = min(script.size() - sent,
+                               (size_t)(pieces() % 4096 + 1));
+            ssize_t count = send(fd, script.data() + sent, piece,
+                                 MSG_NOSIGNAL);
+            if (count <= 0)
+               break;
+            sent += count;
+         }
+         shutdown(fd, SHUT_WR);
+      });
+
+      char buffer[4096];
+      for (ssize_t count; (count = read(fd, buffer, sizeof(buffer))) > 0; )
+         actual.append(buffer, count);
+      sending.join();
+   }
+   if (fd >= 0)
+      close(fd);
+
+   // this one asks for far more than the socket holds and hangs up
+   // after the first piece, so the server writes to a closed socket
+   string rude;
+   for (int i = 0; i < 300; i++)
+      rude += "buy 1 $1." + to_string(10 + i % 2) + "\n";
+   for (int i = 0; i < 300; i++)
+      rude += "lots\n";
+   fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (fd >= 0 && connect(fd, (sockaddr *)&name, sizeof(name)) == 0 &&
+       send(fd, rude.data(), rude.size(), MSG_NOSIGNAL) ==
+          (ssize_t)rude.size())
+   {
+      char buffer[4096];
+      CHECK(read(fd, buffer, sizeof(buffer)) > 0, 2);
+   }
+   if (fd >= 0)
+      close(fd);
+
+   server.stop();
+   serving.join();
+   CHECK(connected, 0);
+   CHECK(withoutPrompts(actual) == withoutPrompts(expected), 1);
+}
+
+/*******************************************
+ * TEST LATENCY
+ * Every value lands in a bucket no more than 1/64 wider
+ * than itself, percentiles agree with sorting the values,
+ * and what many threads record all shows up when merged
+ *******************************************/
+void testLatency(unsigned int seed, long operations)
+{
+   mt19937_64 random(seed);
+   LatencyHistogram histogram;
+   vector <uint64_t> values;
+   for (long step = 0; step < operations; step++)
+   {
+      uint64_t value = random() >> (random() % 64);
+      if (value >> LatencyHistogram::MAX_BITS)
+         value >>= 24;
+      int bucket = LatencyHistogram::bucketOf(value);
+      CHECK(bucket >= 0 && bucket < LatencyHistogram::BUCKETS, step);
+      CHECK(LatencyHistogram::highestIn(bucket) >= value, step);
+      CHECK(LatencyHistogram::highestIn(bucket) - value <= value / 64, step);
+      CHECK(bucket == 0 ||
+            LatencyHistogram::highestIn(bucket - 1) < value, step);
+      histogram.record(value);
+      values.push_back(value);
+   }
+
+   sort(values.begin(), values.end());
+   double fractions[] = { 0.0, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0 };
+   for (int i = 0; i < 7 && !values.empty(); i++)
+   {
+      size_t wanted = (size_t)(fractions[i] * values.size() + 0.5);
+      uint64_t exact = values[wanted == 0 ? 0 : wanted - 1];
+      uint64_t found = (uint64_t)histogram.percentile(fractions[i]);
+      CHECK(found >= exact && found - exact <= exact / 64, i);
+   }
+   CHECK(histogram.getCount() == values.size(), operations);
+   CHECK(LatencyHistogram().percentile(0.5) == 0, operations);
+
+   // two recorders on the same threads keep their counts apart
+   LatencyRecorder recorder(3);
+   LatencyRecorder other(1);
+   vector <thread> threads;
+   for (int t = 0; t < 4; t++)
+      threads.push_back(thread([&, t]()
+      {
+         for (long i = 0; i < operations; i++)
+         {
+            recorder.record(t % 3, i);
+            if (i % 10 == 0)
+               other.record(0, LatencyRecorder::now());
+         }
+      }));
+   for (size_t t = 0; t < threads.size(); t++)
+      threads[t].join();
+
+   CHECK(recorder.merged(0).getCount() == (uint64_t)operations * 2, 0);
+   CHECK(recorder.merged(1).getCount() == (uint64_t)operations, 1);
+   CHECK(recorder.merged(2).getCount() == (uint64_t)operations, 2);
+   CHECK(other.merged(0).getCount() == (uint64_t)(operations + 9) / 10 * 4,
+         3);
+
+   // the stock program answers "stats" with a line for each command
+   // it was given, and not the commands another portfolio was given
+   LatencyRecorder everyone(Command::STATS + 1);
+   PortfolioHistory portfolio(1024, PortfolioHistory::KEEP_TRADES,
+                              &everyone);
+   PortfolioHistory neighbour(1024, PortfolioHistory::KEEP_TRADES,
+                              &everyone);
+   Queue <Event> events;
+   portfolio.apply(parseCommand("buy 10 $1.00"), events);
+   neighbour.apply(parseCommand("sell 10 $1.00"), events);
+   events.clear();
+   portfolio.apply(parseCommand("stats"), events);
+   bool buys = false;
+   bool sells = false;
+   bool stats = false;
+   Event event;
+   while (events.tryPop(event))
+      if (event.kind == Event::LATENCY)
+      {
+         buys |= (event.command == Command::BUY);
+         sells |= (event.command == Command::SELL);
+         stats |= (event.command == Command::STATS);
+         CHECK(event.getLatency()->getCount() == 1, 4);
+         CHECK(event.getSnapshot() == NULL, 4);
+      }
+   CHECK(buys && stats && !sells, 5);
+   CHECK(everyone.merged(Command::BUY).getCount() == 1 &&
+         everyone.merged(Command::SELL).getCount() == 1, 6);
+}
+
+/*******************************************
+ * TEST SYMBOL TABLE
+ * The table against an unordered_map giving out ids in
+ * the same order, with tickers drawn from a small enough
+ * set that most are seen again. Trade records carrying
+ * the ids go through a Queue and come back the same
+ *******************************************/
+void testSymbolTable(unsigned int seed, long operations)
+{
+   mt19937 random(seed);
+   SymbolTable table;
+   unordered_map <string, uint32_t> expected;
+   Queue <TradeRecord> trades;
+   deque <TradeRecord> expectedTrades;
+   const char letters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ.";
+
+   for (long step = 0; step < operations; step++)
+   {
+      string ticker;
+      int length = (int)(random() % (SymbolTable::MAX_LENGTH + 2));
+      for (int i = 0; i < length; i++)
+         ticker += letters[random() % (i < 2 ? 27 : 3)];
+
+      if (length == 0 || length > (int)SymbolTable::MAX_LENGTH)
+      {
+         CHECK(throws([&]() { table.intern(ticker); }), step);
+         CHECK(table.find(ticker) == SymbolTable::NOT_FOUND, step);
+         continue;
+      }
+
+      bool seen = expected.count(ticker) != 0;
+      CHECK(table.find(ticker) ==
+            (seen ? expected[ticker] : SymbolTable::NOT_FOUND), step);
+      uint32_t id = table.intern(ticker);
+      if (!seen)
+      {
+         uint32_t next = (uint32_t)expected.size();
+         expected[ticker] = next;
+      }
+      CHECK(id == expected[ticker], step);
+      CHECK(table.name(id) == ticker, step);
+      CHECK(table.size() == expected.size(), step);
+
+      TradeRecord trade(id, (int)(random() % 1000) + 1,
+                        Dollars((int)(random() % 100000)),
+                        random() % 2 ? TradeRecord::BUY : TradeRecord::SELL);
+      trades.push(trade);
+      expectedTrades.push_back(trade);
+      if (random() % 3 == 0)
+      {
+         TradeRecord front = trades.front();
+         CHECK(front.symbol == expectedTrades.front().symbol &&
+               front.shares == expectedTrades.front().shares &&
+               front.price  == expectedTrades.front().price  &&
+               front.flags  == expectedTrades.front().flags, step);
+         CHECK(table.name(front.symbol) ==
+               table.name(expectedTrades.front().symbol), step);
+         trades.pop();
+         expectedTrades.pop_front();
+      }
+   }
+
+   CHECK(throws([&]() { table.name(table.size()); }), operations);
+   CHECK((size_t)&trades.front() % 16 == 0 || trades.empty(), operations);
+}
+
+/*******************************************
+ * RUN
+ * Run one test, reporting how to reproduce a failure
+ *******************************************/
+bool run(const char * name, void (*test)(unsigned int, long),
+         unsigned int seed, long operations)
+{
+   try
+   {
+      test(seed, operations);
+   }
+   catch (const Failure & failure)
+   {
+      cout << "FAILED " << name << ": " << failure.what
+           << " at step " << failure.step
+           << " (queueTest " << seed << ' ' << operations << ")\n";
+      return false;
+   }
+   catch (const char * error)
+   {
+      cout << "FAILED " << name << ": unexpected \"" << error << "\""
+           << " (queueTest " << seed << ' ' << operations << ")\n";
+      return false;
+   }
+   return true;
+}
+
+/**********************************************************************
+ * MAIN
+ * Every test against every seed
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   unsigned int firstSeed = 1;
+   unsigned int numSeeds  = 5;
+   long operations        = 100000;
+   if (argc > 1)
+   {
+      firstSeed = atoi(argv[1]);
+      numSeeds  = 1;
+   }
+   if (argc > 2)
+      operations = atol(argv[2]);
+
+   int failures = 0;
+   for (unsigned int seed = firstSeed; seed < firstSeed + numSeeds; seed++)
+   {
+      failures += !run("Queue <int>",     testQueue <int>,     seed, operations);
+      failures += !run("Queue <string>",  testQueue <string>,  seed, operations);
+      failures += !run("Queue <Dollars>", testQueue <Dollars>, seed, operations);
+      failures += !run("Queue throws",    testQueueThrows,     seed, operations);
+      failures += !run("StaticQueue <int>", testStaticQueue <int>, seed,
+                       operations);
+      failures += !run("StaticQueue <string>", testStaticQueue <string>, seed,
+                       operations);
+      failures += !run("LotQueue",        testLotQueue,        seed, operations);
+      failures += !run("LotBook <Fifo>",  testLotBook <Fifo>,  seed, operations / 10);
+      failures += !run("LotBook <Lifo>",  testLotBook <Lifo>,  seed, operations / 10);
+      failures += !run("LotBook <Hifo>",  testLotBook <Hifo>,  seed, operations / 10);
+      failures += !run("LotBook <SpecificLot>", testLotBook <SpecificLot>,
+                       seed, operations / 10);
+      failures += !run("LotBook <SharedFifo>", testLotBook <SharedFifo>,
+                       seed, operations / 10);
+      failures += !run("sellLot",         testSpecificLot,     seed, operations);
+      failures += !run("CowQueue",        testCowQueue,        seed, operations / 10);
+      failures += !run("ShmQueue",        testShmQueue,        seed, operations);
+      failures += !run("ShmQueue crash",  testShmCrash,        seed, operations);
+      failures += !run("WorkDeque",       testWorkDeque,       seed, operations);
+      failures += !run("LargeQueue",      testLargeQueue,      seed, operations / 10);
+      failures += !run("OrderBook",       testOrderBook,       seed, operations);
+      failures += !run("PriceWindow",     testPriceWindow,     seed, operations / 10);
+      failures += !run("ReportWriter",    testReportWriter,    seed, operations / 10);
+      failures += !run("FixedPoint",      testFixedPoint,      seed, operations);
+      failures += !run("Portfolio totals", testPortfolioTotals, seed,
+                       operations / 100);
+      failures += !run("PortfolioHistory", testPortfolioHistory, seed,
+                       operations / 100);
+      failures += !run("Symbols",         testSymbols,         seed,
+                       operations / 100);
+      failures += !run("parseCommand",    testParseCommand,    seed, operations);
+      failures += !run("stocksPipeline",  testPipeline,        seed,
+                       operations / 100);
+      failures += !run("StockServer",     testServer,          seed,
+                       operations / 100);
+      failures += !run("JournalCodec",    testJournalCodec,    seed, operations);
+      failures += !run("Latency",         testLatency,         seed, operations);
+      failures += !run("SymbolTable",     testSymbolTable,     seed, operations);
+   }
+
+   cout << (failures ? "Queue tests failed\n" : "Queue tests passed\n");
+   return failures ? 1 : 0;
+}
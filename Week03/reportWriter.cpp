@@ -0,0 +1,282 @@
+/***********************************************************************
+ * Implementation:
+ *    REPORT WRITER
+ * Summary:
+ *    Buffered report text with one write(2) per batch
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cstring>          // for STRLEN, MEMCPY, and MEMSET
+#include <cerrno>           // for ERRNO
+#include <cassert>          // for ASSERT
+#include <new>              // for BAD_ALLOC
+#include <unistd.h>         // for WRITE
+#include <sys/stat.h>       // for FSTAT
+#include <sys/socket.h>     // for SEND
+#include "reportWriter.h"   // for REPORT_WRITER
+using namespace std;
+
+// enough room for the digits of any long long, its sign, and a Dollars
+const int MAX_NUMBER = 32;
+
+/********************************************
+ * REPORT WRITER : NON-DEFAULT CONSTRUCTOR
+ *******************************************/
+ReportWriter :: ReportWriter(int fd, int capacity, Mode mode) :
+   fd(fd), buffer(NULL), vCapacity(capacity), used(0), mode(mode),
+   socket(false), padWidth(0), padAlign(RIGHT)
+{
+   assert(capacity >= MAX_NUMBER);
+   struct stat status;
+   socket = (fstat(fd, &status) == 0 && S_ISSOCK(status.st_mode));
+   try
+   {
+      buffer = new char[capacity];
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to allocate the report buffer";
+   }
+}
+
+/********************************************
+ * REPORT WRITER : DESTRUCTOR
+ * A destructor cannot report a failed write, so
+ * whatever could not be written is dropped
+ *******************************************/
+ReportWriter :: ~ReportWriter()
+{
+   try
+   {
+      if (mode == BLOCKING)
+         flush();
+      else
+         flushSome();
+   }
+   catch (...)
+   {
+   }
+   delete [] buffer;
+}
+
+/********************************************
+ * REPORT WRITER :: FLUSH
+ * write(2) may take less than all of it, or be
+ * interrupted, so keep going until it is all out
+ *******************************************/
+void ReportWriter :: flush()
+{
+   int done = 0;
+   while (done < used)
+   {
+      long count = put(buffer + done, used - done);
+      if (count < 0 && errno == EINTR)
+         continue;
+      if (count <= 0)
+      {
+         used = 0;
+         throw "ERROR: Unable to write the report";
+      }
+      done += (int)count;
+   }
+   used = 0;
+}
+
+/********************************************
+ * REPORT WRITER :: FLUSH SOME
+ * Keep writing until the descriptor would block, then
+ * move what is left to the front of the buffer
+ *******************************************/
+bool ReportWriter :: flushSome()
+{
+   int done = 0;
+   while (done < used)
+   {
+      long count = put(buffer + done, used - done);
+      if (count < 0 && errno == EINTR)
+         continue;
+      if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+         break;
+      if (count <= 0)
+      {
+         used = 0;
+         throw "ERROR: Unable to write the report";
+      }
+      done += (int)count;
+   }
+
+   memmove(buffer, buffer + done, used - done);
+   used -= done;
+   return used == 0;
+}
+
+/********************************************
+ * REPORT WRITER :: PUT
+ * A socket whose reader has gone away fails
+ * with EPIPE rather than raising SIGPIPE
+ *******************************************/
+long ReportWriter :: put(const char * text, int count)
+{
+   if (socket)
+      return send(fd, text, count, MSG_NOSIGNAL);
+   return write(fd, text, count);
+}
+
+/********************************************
+ * REPORT WRITER :: GROW
+ * Double the buffer until it is big enough
+ *******************************************/
+void ReportWriter :: grow(int count)
+{
+   int capacity = vCapacity;
+   while (capacity < count)
+      capacity *= 2;
+
+   char * temp = new(std::nothrow) char[capacity];
+   if (temp == NULL)
+      throw "ERROR: Unable to allocate the report buffer";
+   memcpy(temp, buffer, used);
+   delete [] buffer;
+   buffer = temp;
+   vCapacity = capacity;
+}
+
+/********************************************
+ * REPORT WRITER :: SPACES
+ *******************************************/
+void ReportWriter :: spaces(int count)
+{
+   while (count > 0)
+   {
+      reserve(count < vCapacity ? count : vCapacity);
+      int some = vCapacity - used < count ? vCapacity - used : count;
+      memset(buffer + used, ' ', some);
+      used  += some;
+      count -= some;
+   }
+}
+
+/********************************************
+ * REPORT WRITER :: APPEND
+ * Text longer than the buffer goes out in pieces. The
+ * padding is only worked out when a width was asked for
+ *******************************************/
+void ReportWriter :: append(const char * text, int length)
+{
+   int pad = 0;
+   if (padWidth)
+   {
+      pad = padWidth - length;
+      padWidth = 0;
+      if (pad > 0 && padAlign == RIGHT)
+         spaces(pad);
+   }
+
+   while (length > 0)
+   {
+      reserve(length < vCapacity ? length : vCapacity);
+      int count = vCapacity - used < length ? vCapacity - used : length;
+      memcpy(buffer + used, text, count);
+      used   += count;
+      text   += count;
+      length -= count;
+   }
+
+   if (pad > 0 && padAlign == LEFT)
+      spaces(pad);
+}
+
+/********************************************
+ * REPORT WRITER :: TEXT
+ *******************************************/
+ReportWriter & ReportWriter :: operator << (const char * text)
+{
+   append(text, (int)strlen(text));
+   return *this;
+}
+
+/********************************************
+ * REPORT WRITER :: CHARACTER
+ *******************************************/
+ReportWriter & ReportWriter :: operator << (char c)
+{
+   if (padWidth == 0 && used < vCapacity)
+      buffer[used++] = c;
+   else
+      append(&c, 1);
+   return *this;
+}
+
+/********************************************
+ * FORMAT DIGITS
+ * Write the digits from the right, then copy them
+ * into place in the right order. Returns how many
+ *******************************************/
+static int formatDigits(char * text, unsigned long long value)
+{
+   char digits[MAX_NUMBER];
+   int count = 0;
+   do
+   {
+      digits[MAX_NUMBER - ++count] = (char)('0' + value % 10);
+      value /= 10;
+   }
+   while (value != 0);
+
+   memcpy(text, digits + MAX_NUMBER - count, count);
+   return count;
+}
+
+/********************************************
+ * REPORT WRITER :: INTEGER
+ * The magnitude is taken as unsigned so the most
+ * negative value does not overflow
+ *******************************************/
+ReportWriter & ReportWriter :: operator << (long long value)
+{
+   char text[MAX_NUMBER];
+   int length = 0;
+   if (value < 0)
+   {
+      text[length++] = '-';
+      length += formatDigits(text + length, 0ULL - (unsigned long long)value);
+   }
+   else
+      length += formatDigits(text, (unsigned long long)value);
+   append(text, length);
+   return *this;
+}
+
+ReportWriter & ReportWriter :: operator << (int value)
+{
+   return *this << (long long)value;
+}
+
+/********************************************
+ * REPORT WRITER :: DOLLARS
+ * The same text as the Dollars insertion operator:
+ *   124 cents   --> $1.24
+ *  -498 cents   --> $(4.98)
+ *******************************************/
+ReportWriter & ReportWriter :: operator << (const Dollars & rhs)
+{
+   long long cents = rhs.getCents();
+   bool negative = cents < 0;
+   if (negative)
+      cents = -cents;
+
+   char text[MAX_NUMBER];
+   int length = 0;
+   text[length++] = '$';
+   if (negative)
+      text[length++] = '(';
+   length += formatDigits(text + length, (unsigned long long)(cents / 100));
+   text[length++] = '.';
+   text[length++] = (char)('0' + cents % 100 / 10);
+   text[length++] = (char)('0' + cents % 10);
+   if (negative)
+      text[length++] = ')';
+   append(text, length);
+   return *this;
+}
@@ -0,0 +1,119 @@
+/***********************************************************************
+ * Header:
+ *    REPORT WRITER
+ * Summary:
+ *    A sink for report text that collects it in one buffer and hands
+ *    it to the operating system with a single write(2) when asked to,
+ *    or when the buffer fills. Numbers and Dollars are turned into
+ *    text right here rather than through an ostream and its locale,
+ *    so a report of thousands of lines costs a handful of system calls
+ *    instead of one flush per line. Like an ostream, a writer can be
+ *    told how wide the next item is to be, so reports line up in
+ *    columns.
+ *
+ *    A writer for a non-blocking socket never waits: its buffer grows
+ *    rather than being flushed when it fills, and flushSome() writes
+ *    only what the socket will take right now. Writing to a socket
+ *    whose reader has gone is an error thrown, not a SIGPIPE.
+ *
+ *    This will contain the class definition of:
+ *        ReportWriter     : buffered text going to a file descriptor
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef REPORT_WRITER_H
+#define REPORT_WRITER_H
+
+#include "dollars.h"   // for DOLLARS
+
+/******************************************
+ * REPORT WRITER
+ * Text collected in a buffer and written out a batch at
+ * a time. Nothing reaches the file descriptor until flush()
+ * is called, the buffer is full, or the writer goes away
+ ******************************************/
+class ReportWriter
+{
+public:
+   // whether writing to the file descriptor can wait
+   enum Mode { BLOCKING, NON_BLOCKING };
+
+   // which side of a padded item the text goes on
+   enum Align { RIGHT, LEFT };
+
+   // non-default constructor : write to "fd", standard out by default
+   ReportWriter(int fd = 1, int capacity = 65536, Mode mode = BLOCKING);
+
+   // destructor : write out whatever is left, if we can wait for it
+   ~ReportWriter();
+
+   // append text
+   ReportWriter & operator << (const char * text);
+   ReportWriter & operator << (char c);
+   ReportWriter & operator << (int value);
+   ReportWriter & operator << (long long value);
+   ReportWriter & operator << (const Dollars & rhs);
+
+   // pad the next item appended with spaces to at least "count"
+   // characters, on the left like ostream::width() or on the right
+   // for LEFT. It applies to that item only
+   ReportWriter & width(int count, Align align = RIGHT)
+   {
+      padWidth = count;
+      padAlign = align;
+      return *this;
+   }
+
+   // hand everything collected so far to the operating system
+   void flush();
+
+   // hand over what the file descriptor will take without waiting.
+   // Returns true once nothing is left
+   bool flushSome();
+
+   // how many characters are waiting to be written
+   int size() const     { return used;     }
+   int capacity() const { return vCapacity; }
+
+private:
+   // a writer owns its buffer, so it cannot be copied
+   ReportWriter(const ReportWriter & rhs);
+   ReportWriter & operator = (const ReportWriter & rhs);
+
+   // make sure "count" more characters fit, flushing if they do not.
+   // A NON_BLOCKING writer grows instead
+   void reserve(int count)
+   {
+      if (used + count <= vCapacity)
+         return;
+      if (mode == BLOCKING)
+         flush();
+      else
+         grow(used + count);
+   }
+
+   // make the buffer hold at least "count" characters
+   void grow(int count);
+
+   // append "length" characters of text, padded to the width
+   void append(const char * text, int length);
+
+   // append "count" spaces
+   void spaces(int count);
+
+   // one write(2), or send(2) for a socket so a closed one does not
+   // raise SIGPIPE
+   long put(const char * text, int count);
+
+   int fd;            // where the text goes
+   char * buffer;     // the text that has not been written yet
+   int vCapacity;     // how big the buffer is
+   int used;          // how much of the buffer holds text
+   Mode mode;         // whether a flush may wait
+   bool socket;       // whether the file descriptor is a socket
+   int padWidth;      // how wide the next item is to be
+   Align padAlign;    // which side of it the padding goes
+};
+
+#endif // REPORT_WRITER_H
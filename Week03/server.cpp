@@ -0,0 +1,389 @@
+/***********************************************************************
+ * Implementation:
+ *    STOCK SERVER
+ * Summary:
+ *    The stock program behind a Unix domain or loopback TCP socket,
+ *    with every connection served from one epoll loop
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cstring>          // for MEMCHR and STRNCPY
+#include <cstdlib>          // for ATOI
+#include <cctype>           // for ISDIGIT and ISSPACE
+#include <cerrno>           // for ERRNO
+#include <unistd.h>         // for READ and CLOSE
+#include <sys/epoll.h>      // for EPOLL_WAIT
+#include <sys/socket.h>     // for SOCKET and ACCEPT4
+#include <sys/un.h>         // for SOCKADDR_UN
+#include <netinet/in.h>     // for SOCKADDR_IN
+#include <netinet/tcp.h>    // for TCP_NODELAY
+#include <arpa/inet.h>      // for HTONS
+#include "server.h"         // for STOCK_SERVER
+using namespace std;
+
+// how much one read(2) can take from a client
+const int READ_SIZE = 65536;
+
+// how many ready connections one epoll_wait() can report
+const int MAX_READY = 256;
+
+// a line longer than this is not a command, so the client is dropped
+const int MAX_LINE = 4096;
+
+// stop reading from a client that has this much it has not taken yet
+const int MAX_PENDING = 1 << 20;
+
+// how long epoll_wait() sleeps before looking at stop() again
+const int POLL_MS = 100;
+
+/********************************************
+ * STOCK SERVER :: CONNECTION : NON-DEFAULT CONSTRUCTOR
+ * The answers start in a small buffer that grows
+ * rather than waiting for a slow client
+ *******************************************/
+StockServer :: Connection :: Connection(int fd) :
+   fd(fd), out(fd, 1024, ReportWriter::NON_BLOCKING), events(EPOLLIN),
+   closing(false), dirty(false)
+{
+}
+
+/********************************************
+ * STOCK SERVER : NON-DEFAULT CONSTRUCTOR
+ * An address with a slash in it is a socket path,
+ * one made only of digits is a port on 127.0.0.1
+ *******************************************/
+StockServer :: StockServer(const char * address) :
+   listener(-1), epoll(-1), buffer(NULL), connections(0), stopping(false)
+{
+   bool local = (strchr(address, '/') != NULL);
+   bool port  = (*address != '\0');
+   for (const char * p = address; *p; p++)
+      port = port && isdigit((unsigned char)*p);
+   if (!local && !port)
+      throw "ERROR: the address must be a socket path or a port";
+
+   if (local)
+   {
+      sockaddr_un name;
+      memset(&name, 0, sizeof(name));
+      if (strlen(address) >= sizeof(name.sun_path))
+         throw "ERROR: the socket path is too long";
+      name.sun_family = AF_UNIX;
+      strncpy(name.sun_path, address, sizeof(name.sun_path) - 1);
+
+      listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        0);
+      unlink(address);
+      if (listener < 0 ||
+          bind(listener, (sockaddr *)&name, sizeof(name)) != 0)
+      {
+         if (listener >= 0)
+            close(listener);
+         throw "ERROR: Unable to bind the socket path";
+      }
+      path = address;
+   }
+   else
+   {
+      sockaddr_in name;
+      memset(&name, 0, sizeof(name));
+      name.sin_family = AF_INET;
+      name.sin_port = htons((unsigned short)atoi(address));
+      name.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+      listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                        0);
+      int yes = 1;
+      if (listener < 0 ||
+          setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes,
+                     sizeof(yes)) != 0 ||
+          bind(listener, (sockaddr *)&name, sizeof(name)) != 0)
+      {
+         if (listener >= 0)
+            close(listener);
+         throw "ERROR: Unable to bind the port";
+      }
+   }
+
+   epoll_event event;
+   event.events = EPOLLIN;
+   event.data.fd = listener;
+   if (listen(listener, SOMAXCONN) != 0 ||
+       (epoll = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+       epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event) != 0)
+   {
+      if (epoll >= 0)
+         close(epoll);
+      close(listener);
+      if (!path.empty())
+         unlink(path.c_str());
+      throw "ERROR: Unable to listen on the socket";
+   }
+
+   buffer = new char[READ_SIZE];
+}
+
+/********************************************
+ * STOCK SERVER : DESTRUCTOR
+ * Clients that have not taken their answers yet
+ * lose them; nobody is waiting for us to finish
+ *******************************************/
+StockServer :: ~StockServer()
+{
+   for (int fd = 0; fd < (int)clients.size(); fd++)
+      if (clients[fd] != NULL)
+         drop(fd);
+   close(epoll);
+   close(listener);
+   if (!path.empty())
+      unlink(path.c_str());
+   delete [] buffer;
+}
+
+/********************************************
+ * STOCK SERVER :: RUN
+ * Each round reads from every client that is ready,
+ * then sends each of them everything it was given
+ *******************************************/
+void StockServer :: run()
+{
+   epoll_event ready[MAX_READY];
+   while (!stopping)
+   {
+      int count = epoll_wait(epoll, ready, MAX_READY, POLL_MS);
+      if (count < 0 && errno == EINTR)
+         continue;
+      if (count < 0)
+         throw "ERROR: Unable to wait for the clients";
+
+      for (int i = 0; i < count; i++)
+      {
+         int fd = ready[i].data.fd;
+         if (fd == listener)
+         {
+            acceptAll();
+            continue;
+         }
+
+         Connection & connection = *clients[fd];
+         if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            receive(connection);
+         if ((ready[i].events & EPOLLOUT) && !connection.dirty)
+         {
+            connection.dirty = true;
+            touched.push_back(fd);
+         }
+      }
+
+      sendAll();
+   }
+}
+
+/********************************************
+ * STOCK SERVER :: ACCEPT ALL
+ * When we are out of file descriptors the client
+ * waits in the backlog until someone leaves
+ *******************************************/
+void StockServer :: acceptAll()
+{
+   while (true)
+   {
+      int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0 && errno == EINTR)
+         continue;
+      if (fd < 0)
+         return;
+
+      // answers go back as soon as they are written
+      int yes = 1;
+      if (path.empty())
+         setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+      epoll_event event;
+      event.events = EPOLLIN;
+      event.data.fd = fd;
+      if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+      {
+         close(fd);
+         continue;
+      }
+
+      if (fd >= (int)clients.size())
+         clients.resize(fd + 1, NULL);
+      clients[fd] = new Connection(fd);
+      connections++;
+   }
+}
+
+/********************************************
+ * STOCK SERVER :: RECEIVE
+ * One read per round, so a client that sends a lot
+ * cannot keep the others waiting. epoll is level
+ * triggered and will bring us back for the rest
+ *******************************************/
+void StockServer :: receive(Connection & connection)
+{
+   if (connection.closing)
+      return;
+
+   ssize_t count;
+   do
+      count = read(connection.fd, buffer, READ_SIZE);
+   while (count < 0 && errno == EINTR);
+
+   if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+
+   if (count > 0)
+      consume(connection, buffer, buffer + count);
+   else
+   {
+      // the client is done sending. A last line needs no newline
+      if (count == 0 && !connection.partial.empty())
+      {
+         string line;
+         line.swap(connection.partial);
+         execute(connection, line.data(), line.data() + line.size());
+      }
+      connection.closing = true;
+   }
+
+   if (!connection.dirty)
+   {
+      connection.dirty = true;
+      touched.push_back(connection.fd);
+   }
+}
+
+/********************************************
+ * STOCK SERVER :: CONSUME
+ * Answer every complete line where it sits in the
+ * buffer. Only a line split between reads is copied
+ *******************************************/
+void StockServer :: consume(Connection & connection, const char * begin,
+                            const char * end)
+{
+   const char * newline = (const char *)memchr(begin, '\n', end - begin);
+
+   // finish the line the last read left off in the middle of
+   if (!connection.partial.empty())
+   {
+      if (newline == NULL)
+      {
+         connection.partial.append(begin, end);
+         if ((int)connection.partial.size() > MAX_LINE)
+            connection.closing = true;
+         return;
+      }
+      string line;
+      line.swap(connection.partial);
+      line.append(begin, newline);
+      execute(connection, line.data(), line.data() + line.size());
+      begin = newline + 1;
+      newline = (const char *)memchr(begin, '\n', end - begin);
+   }
+
+   while (newline != NULL && !connection.closing)
+   {
+      execute(connection, begin, newline);
+      begin = newline + 1;
+      newline = (const char *)memchr(begin, '\n', end - begin);
+   }
+
+   if (!connection.closing && begin != end)
+   {
+      if (end - begin > MAX_LINE)
+         connection.closing = true;
+      else
+         connection.partial.assign(begin, end);
+   }
+}
+
+/********************************************
+ * STOCK SERVER :: EXECUTE
+ * One line from a client. Blank lines are ignored
+ * rather than answered as invalid, so "\r\n" and
+ * trailing newlines do no harm. The events queue is
+ * the server's, so a line allocates nothing
+ *******************************************/
+void StockServer :: execute(Connection & connection, const char * begin,
+                            const char * end)
+{
+   const char * p = begin;
+   while (p != end && isspace((unsigned char)*p))
+      p++;
+   if (p == end || connection.closing)
+      return;
+
+   Command command = parseCommand(begin, end);
+   portfolio.apply(command, events);
+   Event event;
+   while (events.tryPop(event))
+      connection.out << event;
+   events.clear();
+
+   if (command.type == Command::QUIT)
+      connection.closing = true;
+}
+
+/********************************************
+ * STOCK SERVER :: SEND ALL
+ * One write for each client that was given something
+ * this round. What a client does not take waits for
+ * EPOLLOUT, and a client that is far behind is not
+ * read from until it catches up
+ *******************************************/
+void StockServer :: sendAll()
+{
+   for (int i = 0; i < (int)touched.size(); i++)
+   {
+      int fd = touched[i];
+      Connection & connection = *clients[fd];
+      connection.dirty = false;
+
+      try
+      {
+         connection.out.flushSome();
+      }
+      catch (const char *)
+      {
+         drop(fd);
+         continue;
+      }
+
+      int waiting = connection.out.size();
+      if (connection.closing && waiting == 0)
+      {
+         drop(fd);
+         continue;
+      }
+
+      unsigned int events = 0;
+      if (!connection.closing && waiting < MAX_PENDING)
+         events |= EPOLLIN;
+      if (waiting > 0)
+         events |= EPOLLOUT;
+      if (events != connection.events)
+      {
+         epoll_event event;
+         event.events = events;
+         event.data.fd = fd;
+         epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+         connection.events = events;
+      }
+   }
+   touched.clear();
+}
+
+/********************************************
+ * STOCK SERVER :: DROP
+ * Closing the descriptor also takes it out of epoll
+ *******************************************/
+void StockServer :: drop(int fd)
+{
+   delete clients[fd];
+   clients[fd] = NULL;
+   close(fd);
+   connections--;
+}
@@ -0,0 +1,109 @@
+/***********************************************************************
+ * Header:
+ *    STOCK SERVER
+ * Summary:
+ *    The stock program served over a local socket, so many clients can
+ *    buy and sell against one portfolio at the same time. The address
+ *    is either the path of a Unix domain socket, such as
+ *    /tmp/stock.sock, or a port number on the loopback interface.
+ *
+ *    One thread runs an epoll loop over every connection. Commands are
+ *    parsed straight out of the receive buffer; only a line that is
+ *    split across two reads is copied. A client may send many commands
+ *    without waiting for the answers, and everything that is answered
+ *    in one round of the loop goes back to a client in one write.
+ *    A client that goes away is dropped; its answers are sent with
+ *    MSG_NOSIGNAL, so the server never sees a SIGPIPE.
+ *
+ *    This will contain the class definition of:
+ *        StockServer      : the stock program behind a socket
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>           // for ATOMIC
+#include <string>           // for STRING
+#include <vector>           // for VECTOR
+#include "stock.h"          // for PORTFOLIO_HISTORY and COMMAND
+#include "reportWriter.h"   // for REPORT_WRITER
+
+/******************************************
+ * STOCK SERVER
+ * Accepts connections and answers their commands
+ * from one shared PortfolioHistory
+ ******************************************/
+class StockServer
+{
+public:
+   // non-default constructor : listen on a socket path or a port
+   StockServer(const char * address);
+
+   // destructor : close every connection and remove the socket path
+   ~StockServer();
+
+   // answer clients until stop() is called
+   void run();
+
+   // ask run() to return. Safe to call from a signal handler
+   void stop()                       { stopping = true;           }
+
+   // how many clients are connected right now
+   int getConnections() const        { return connections;        }
+
+   // the portfolio every client trades against
+   const PortfolioHistory & getPortfolio() const { return portfolio; }
+
+private:
+   /******************************************
+    * CONNECTION
+    * One client: the part of a line it has sent so far,
+    * and the answers it has not taken yet
+    ******************************************/
+   struct Connection
+   {
+      Connection(int fd);
+
+      int fd;
+      std::string partial;    // a line that has not ended yet
+      ReportWriter out;       // answers waiting to go back
+      unsigned int events;    // what epoll is watching for
+      bool closing;           // no more commands; close once "out" is sent
+      bool dirty;             // has something to send this round
+   };
+
+   // no copying a listening socket
+   StockServer(const StockServer & rhs);
+   StockServer & operator = (const StockServer & rhs);
+
+   // take every connection that is waiting
+   void acceptAll();
+
+   // read what one client sent and answer every complete line
+   void receive(Connection & connection);
+   void consume(Connection & connection, const char * begin,
+                const char * end);
+   void execute(Connection & connection, const char * begin,
+                const char * end);
+
+   // send what the clients touched this round were given
+   void sendAll();
+
+   // stop watching a client and let it go
+   void drop(int fd);
+
+   int listener;                       // the listening socket
+   int epoll;                          // the epoll instance
+   std::string path;                   // the Unix socket path, if any
+   PortfolioHistory portfolio;         // shared by every client
+   Queue <Event> events;               // the answer to one line
+   std::vector <Connection *> clients; // by file descriptor
+   std::vector <int> touched;          // with something to send
+   char * buffer;                      // what read(2) fills
+   int connections;                    // how many are open
+   std::atomic <bool> stopping;        // set by stop()
+};
+
+#endif // SERVER_H
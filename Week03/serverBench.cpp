@@ -0,0 +1,298 @@
+/***********************************************************************
+ * Program:
+ *    SERVER BENCH
+ * Summary:
+ *    Starts the StockServer in a child process, connects many clients
+ *    to it, and has every client trade as fast as it is answered: send
+ *    a buy or a sell and a display, wait for the report, and send the
+ *    next one. Reports the latency of those round trips and how many
+ *    of them the server answered a second.
+ *
+ *        serverBench [connections] [requests] [address]
+ *
+ *    The address is a socket path or a loopback port, as for the server.
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#include <iostream>         // for COUT
+#include <vector>           // for VECTOR
+#include <algorithm>        // for SORT
+#include <chrono>           // for STEADY_CLOCK
+#include <cstdio>           // for SNPRINTF
+#include <cstdlib>          // for ATOI
+#include <cstring>          // for STRCHR
+#include <cerrno>           // for ERRNO
+#include <csignal>          // for SIGACTION
+#include <unistd.h>         // for FORK and READ
+#include <fcntl.h>          // for FCNTL
+#include <sys/epoll.h>      // for EPOLL_WAIT
+#include <sys/socket.h>     // for CONNECT
+#include <sys/un.h>         // for SOCKADDR_UN
+#include <sys/wait.h>       // for WAITPID
+#include <sys/resource.h>   // for SETRLIMIT
+#include <netinet/in.h>     // for SOCKADDR_IN
+#include <netinet/tcp.h>    // for TCP_NODELAY
+#include <arpa/inet.h>      // for HTONS
+#include "server.h"         // for STOCK_SERVER
+using namespace std;
+
+// a display answers with this many lines, and a buy or a sell with none
+const int LINES_PER_REQUEST = 3;
+
+typedef chrono::steady_clock Clock;
+
+/*******************************************
+ * CLIENT
+ * One connection and the round trip it is waiting on
+ *******************************************/
+struct Client
+{
+   int fd;
+   int sent;                 // requests sent so far
+   int lines;                // lines of the answer received so far
+   Clock::time_point start;  // when the request went out
+};
+
+// the server in the child process, for the SIGTERM handler
+StockServer * server = NULL;
+
+/*******************************************
+ * ON TERMINATE
+ *******************************************/
+void onTerminate(int)
+{
+   if (server != NULL)
+      server->stop();
+}
+
+/*******************************************
+ * SERVE
+ * The child: answer clients until the parent is done
+ *******************************************/
+int serve(const char * address)
+{
+   try
+   {
+      StockServer stockServer(address);
+      server = &stockServer;
+
+      struct sigaction action;
+      memset(&action, 0, sizeof(action));
+      action.sa_handler = onTerminate;
+      sigaction(SIGTERM, &action, NULL);
+
+      stockServer.run();
+      server = NULL;
+      cout << "server: " << stockServer.getPortfolio().getTrades()
+           << " trades\n";
+   }
+   catch (const char * error)
+   {
+      cout << error << endl;
+      return 1;
+   }
+   return 0;
+}
+
+/*******************************************
+ * CONNECT TO
+ * A blocking connect, so a full backlog waits rather
+ * than fails. Returns -1 if the server is not there
+ *******************************************/
+int connectTo(const char * address)
+{
+   int fd;
+   int result;
+   if (strchr(address, '/') != NULL)
+   {
+      sockaddr_un name;
+      memset(&name, 0, sizeof(name));
+      name.sun_family = AF_UNIX;
+      strncpy(name.sun_path, address, sizeof(name.sun_path) - 1);
+      fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      result = connect(fd, (sockaddr *)&name, sizeof(name));
+   }
+   else
+   {
+      sockaddr_in name;
+      memset(&name, 0, sizeof(name));
+      name.sin_family = AF_INET;
+      name.sin_port = htons((unsigned short)atoi(address));
+      name.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      result = connect(fd, (sockaddr *)&name, sizeof(name));
+      int yes = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+   }
+
+   if (result != 0)
+   {
+      close(fd);
+      return -1;
+   }
+   fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+   return fd;
+}
+
+/*******************************************
+ * SEND REQUEST
+ * Buys and sells of the same size take turns, so the
+ * holdings stay small however long the run is
+ *******************************************/
+bool sendRequest(Client & client)
+{
+   char request[64];
+   int length = snprintf(request, sizeof(request),
+                         "%s 10 $1.%02d\ndisplay\n",
+                         client.sent % 2 ? "sell" : "buy",
+                         (client.fd + client.sent) % 100);
+   client.start = Clock::now();
+   client.lines = 0;
+   client.sent++;
+   return write(client.fd, request, length) == length;
+}
+
+/*******************************************
+ * PERCENTILE
+ * Of latencies that are already sorted, in microseconds
+ *******************************************/
+double percentile(const vector <long long> & sorted, double fraction)
+{
+   size_t index = (size_t)(fraction * (sorted.size() - 1));
+   return sorted[index] / 1000.0;
+}
+
+/**********************************************************************
+ * MAIN
+ * Connect everyone, start them all trading, and time
+ * every round trip until each has made its requests
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   int count    = (argc > 1 ? atoi(argv[1]) : 10000);
+   int requests = (argc > 2 ? atoi(argv[2]) : 20);
+   const char * address = (argc > 3 ? argv[3] : "/tmp/serverBench.sock");
+
+   // both the server and the clients need a descriptor per connection
+   rlimit limit;
+   getrlimit(RLIMIT_NOFILE, &limit);
+   limit.rlim_cur = limit.rlim_max;
+   setrlimit(RLIMIT_NOFILE, &limit);
+   if ((rlim_t)count + 16 > limit.rlim_cur)
+   {
+      cout << "Only " << limit.rlim_cur << " file descriptors are allowed\n";
+      return 1;
+   }
+
+   cout.flush();
+   pid_t child = fork();
+   if (child == 0)
+      return serve(address);
+
+   // wait for the server to start listening
+   vector <Client> clients(count);
+   int fd = -1;
+   for (int i = 0; i < 500 && fd < 0; i++)
+      if ((fd = connectTo(address)) < 0)
+         usleep(10000);
+
+   Clock::time_point connecting = Clock::now();
+   for (int i = 0; i < count; i++)
+   {
+      if (i > 0)
+         fd = connectTo(address);
+      if (fd < 0)
+      {
+         cout << "Unable to connect client " << i << endl;
+         kill(child, SIGTERM);
+         waitpid(child, NULL, 0);
+         return 1;
+      }
+      clients[i].fd = fd;
+      clients[i].sent = 0;
+   }
+   double connectSeconds =
+      chrono::duration <double> (Clock::now() - connecting).count();
+
+   int epoll = epoll_create1(EPOLL_CLOEXEC);
+   for (int i = 0; i < count; i++)
+   {
+      epoll_event event;
+      event.events = EPOLLIN;
+      event.data.u32 = i;
+      epoll_ctl(epoll, EPOLL_CTL_ADD, clients[i].fd, &event);
+   }
+
+   // everyone sends, then each sends again as soon as it is answered
+   vector <long long> latencies;
+   latencies.reserve((size_t)count * requests);
+   Clock::time_point start = Clock::now();
+   int done = 0;
+   bool failed = false;
+   for (int i = 0; i < count && !failed; i++)
+      failed = !sendRequest(clients[i]);
+
+   epoll_event ready[256];
+   char buffer[4096];
+   while (done < count && !failed)
+   {
+      int readyCount = epoll_wait(epoll, ready, 256, 5000);
+      if (readyCount <= 0)
+      {
+         failed = (readyCount == 0 || errno != EINTR);
+         continue;
+      }
+
+      for (int r = 0; r < readyCount && !failed; r++)
+      {
+         Client & client = clients[ready[r].data.u32];
+         ssize_t got = read(client.fd, buffer, sizeof(buffer));
+         if (got < 0 && (errno == EAGAIN || errno == EINTR))
+            continue;
+         if (got <= 0)
+         {
+            failed = true;
+            break;
+         }
+
+         for (ssize_t i = 0; i < got; i++)
+            client.lines += (buffer[i] == '\n');
+         if (client.lines < LINES_PER_REQUEST)
+            continue;
+
+         latencies.push_back(chrono::duration_cast <chrono::nanoseconds>
+                             (Clock::now() - client.start).count());
+         if (client.sent == requests)
+            done++;
+         else
+            failed = !sendRequest(client);
+      }
+   }
+   double seconds = chrono::duration <double> (Clock::now() - start).count();
+
+   for (int i = 0; i < count; i++)
+      close(clients[i].fd);
+   close(epoll);
+   kill(child, SIGTERM);
+   int status = 0;
+   waitpid(child, &status, 0);
+
+   if (failed || latencies.empty())
+   {
+      cout << "The server stopped answering after " << latencies.size()
+           << " round trips\n";
+      return 1;
+   }
+
+   sort(latencies.begin(), latencies.end());
+   cout << count << " connections in " << connectSeconds << " s, "
+        << requests << " round trips each\n";
+   cout << "throughput\t" << latencies.size() / seconds
+        << " round trips/s\n";
+   cout << "latency us\tp50 " << percentile(latencies, 0.50)
+        << "\tp99 " << percentile(latencies, 0.99)
+        << "\tp99.9 " << percentile(latencies, 0.999)
+        << "\tmax " << latencies.back() / 1000.0 << endl;
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : 1;
+}
@@ -0,0 +1,418 @@
+/***********************************************************************
+* Header:
+*    SHARED MEMORY QUEUE
+* Summary:
+*    A fixed size Queue that lives in a POSIX shared memory segment so
+*    one process can push and another can pop with no socket and no
+*    serialization in between. Items are copied as raw bytes, so only
+*    trivially copyable types such as Dollars and Lot can be used.
+*
+*    There must be one producer process and one consumer process. The
+*    head and the tail are counters that only grow, stored as atomics
+*    in the segment. A producer writes the item before it moves the
+*    tail and a consumer reads the item before it moves the head, so
+*    a process that dies in the middle of a push or a pop leaves the
+*    queue as it was before that operation. Attaching again picks up
+*    from there: nothing is lost, and at worst an item the consumer
+*    was reading when it died is read a second time.
+*
+*    Every process using the segment holds a shared flock(2) on it for
+*    as long as it is attached, and the creator holds an exclusive one
+*    until the queue is set up. The kernel drops a dead process's
+*    locks, so a segment is only stale, and only ever unlinked, when
+*    nobody holds a lock on it. A segment that a live process is still
+*    setting up, or that holds a queue of another type, is left alone
+*    and the constructor throws.
+*
+*    This will contain the class definition of:
+*        ShmQueue         : a Queue of T in shared memory
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef SHM_QUEUE_H
+#define SHM_QUEUE_H
+
+#include <atomic>        // for ATOMIC
+#include <type_traits>   // for IS_TRIVIALLY_COPYABLE
+#include <cstdint>       // for UINT32_T and UINT64_T
+#include <cstring>       // for STRLEN
+#include <cassert>       // for ASSERT
+#include <new>           // for placement NEW
+#include <fcntl.h>       // for O_CREAT
+#include <sys/mman.h>    // for SHM_OPEN and MMAP
+#include <sys/stat.h>    // for FSTAT
+#include <sys/file.h>    // for FLOCK
+#include <unistd.h>      // for FTRUNCATE, CLOSE, and USLEEP
+
+/************************************************
+ * SHM QUEUE
+ * A single-producer single-consumer ring buffer in
+ * a named shared memory segment
+ ***********************************************/
+template <class T>
+class ShmQueue
+{
+   static_assert(std::is_trivially_copyable <T> ::value,
+                 "ShmQueue items are copied as raw bytes");
+
+   // an atomic with a lock inside would be a lock in this process's
+   // memory, which the other process cannot see
+   static_assert(std::atomic <uint32_t> ::is_always_lock_free &&
+                 std::atomic <uint64_t> ::is_always_lock_free,
+                 "ShmQueue needs atomics that work across processes");
+
+public:
+   // how to get at the segment
+   enum Mode
+   {
+      CREATE,    // start over with an empty queue, unless it is in use
+      ATTACH,    // use the queue that is already there
+      OPEN       // attach if there is a good queue there, create one if
+                 //    there is none, and replace one that is stale
+   };
+
+   // how long to wait for another process to finish setting a queue up
+   static constexpr int SETUP_MICROSECONDS = 200000;
+
+   // non-default constructor : create or attach to the named segment.
+   // The capacity is rounded up to a power of two and is only used
+   // when the queue is created
+   ShmQueue(const char * name, Mode mode, int capacity = 0);
+
+   // destructor : let go of the segment and our lock on it, but leave
+   // it for others
+   ~ShmQueue()
+   {
+      munmap(header, bytes);
+      close(fd);
+   }
+
+   // remove the named segment from the system
+   static void remove(const char * name) { shm_unlink(name);      }
+
+   // how many items are waiting
+   bool empty() const noexcept { return size() == 0;              }
+   int size() const noexcept
+   {
+      return (int)(header->tail.load(std::memory_order_acquire) -
+                   header->head.load(std::memory_order_acquire));
+   }
+   int capacity() const noexcept { return (int)header->capacity;  }
+
+   // producer: add an item. Returns false if the queue is full
+   bool push(const T & t);
+
+   // consumer: the oldest item, then remove it
+   T front() const;
+   void pop();
+
+   // consumer: copy out the oldest item and remove it in one step.
+   // False if there is nothing there, for polling without a throw
+   bool tryPop(T & t) noexcept;
+
+private:
+   /******************************************
+    * HEADER
+    * The start of the segment. The head and the tail
+    * are on their own cache lines so the producer and
+    * the consumer do not slow each other down
+    ******************************************/
+   struct Header
+   {
+      uint32_t magic;        // MAGIC once the queue is set up
+      uint32_t itemSize;     // sizeof(T) of the process that created it
+      uint32_t capacity;     // how many items fit, a power of two
+      std::atomic <uint32_t> ready;   // set last when the queue is created
+      alignas(64) std::atomic <uint64_t> head;   // items ever popped
+      alignas(64) std::atomic <uint64_t> tail;   // items ever pushed
+   };
+
+   enum { MAGIC = 0x51554555 };   // "QUEU"
+
+   // what attach() found
+   enum Found
+   {
+      ATTACHED,  // a good queue, which we now hold a shared lock on
+      MISSING,   // no segment by that name
+      STALE,     // a segment nobody holds that was never set up
+      IN_USE,    // a live process is setting it up, or it is not ours
+   };
+
+   // each one maps and unlocks the segment on its own
+   ShmQueue(const ShmQueue & rhs);
+   ShmQueue & operator = (const ShmQueue & rhs);
+
+   // the number of bytes the segment needs for a capacity
+   static size_t sizeFor(uint32_t capacity)
+   {
+      return sizeof(Header) + capacity * sizeof(T);
+   }
+
+   // make a new segment, or attach to the existing one
+   bool create(const char * name, uint32_t capacity);
+   Found attach(const char * name);
+
+   // does the segment we hold still have the name? Only then is it
+   // ours to unlink
+   static bool named(const char * name, int fd);
+
+   T * slot(uint64_t count) const
+   {
+      return (T *)(header + 1) + (count & (header->capacity - 1));
+   }
+
+   Header * header;   // the start of the mapped segment
+   size_t bytes;      // how big the mapping is
+   int fd;            // the segment, held open for our lock on it
+};
+
+/**********************************************
+ * SHM QUEUE : NON-DEFAULT CONSTRUCTOR
+ * A segment is only unlinked while we hold an exclusive
+ * lock on it, so nobody else is using it
+ **********************************************/
+template <class T>
+ShmQueue <T> :: ShmQueue(const char * name, Mode mode, int capacity) :
+   header(NULL), bytes(0), fd(-1)
+{
+   assert(name != NULL && name[0] == '/');
+
+   // round the capacity up to a power of two for mask indexing
+   uint32_t rounded = 1;
+   while ((int)rounded < capacity)
+      rounded *= 2;
+
+   if (mode == CREATE)
+   {
+      int old = shm_open(name, O_RDWR, 0600);
+      if (old >= 0)
+      {
+         bool unused = (flock(old, LOCK_EX | LOCK_NB) == 0);
+         if (unused && named(name, old))
+            shm_unlink(name);
+         close(old);
+         if (!unused)
+            throw "ERROR: The shared queue is in use";
+      }
+      if (!create(name, rounded))
+         throw "ERROR: Unable to create the shared queue";
+      return;
+   }
+
+   Found found = attach(name);
+   if (found == ATTACHED)
+      return;
+   if (mode == ATTACH || found == IN_USE)
+      throw "ERROR: Unable to attach to the shared queue";
+
+   // there is no queue, or one left half set up by a process that died
+   // while creating it. If someone else beats us to making the new
+   // one, use theirs
+   if (!create(name, rounded) && attach(name) != ATTACHED)
+      throw "ERROR: Unable to create the shared queue";
+}
+
+/**********************************************
+ * SHM QUEUE :: NAMED
+ * Is the segment open on "fd" the one "name" opens now?
+ **********************************************/
+template <class T>
+bool ShmQueue <T> :: named(const char * name, int fd)
+{
+   int current = shm_open(name, O_RDONLY, 0600);
+   if (current < 0)
+      return false;
+   struct stat ours;
+   struct stat theirs;
+   bool same = fstat(fd, &ours) == 0 && fstat(current, &theirs) == 0 &&
+               ours.st_ino == theirs.st_ino && ours.st_dev == theirs.st_dev;
+   close(current);
+   return same;
+}
+
+/**********************************************
+ * SHM QUEUE :: CREATE
+ * Only the process whose O_EXCL open succeeds sets the
+ * queue up, and it holds an exclusive lock until it is
+ * done. "ready" is stored last, so anyone attaching
+ * never sees a half built header
+ **********************************************/
+template <class T>
+bool ShmQueue <T> :: create(const char * name, uint32_t capacity)
+{
+   int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0)
+      return false;
+   flock(fd, LOCK_EX);
+
+   bytes = sizeFor(capacity);
+   void * memory = MAP_FAILED;
+   if (ftruncate(fd, bytes) == 0)
+      memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      shm_unlink(name);
+      close(fd);
+      bytes = 0;
+      return false;
+   }
+
+   header = new (memory) Header;
+   header->magic    = MAGIC;
+   header->itemSize = sizeof(T);
+   header->capacity = capacity;
+   header->head.store(0, std::memory_order_relaxed);
+   header->tail.store(0, std::memory_order_relaxed);
+   header->ready.store(1, std::memory_order_release);
+
+   // from here on we are one user among others
+   flock(fd, LOCK_SH);
+   this->fd = fd;
+   return true;
+}
+
+/**********************************************
+ * SHM QUEUE :: ATTACH
+ * Map an existing segment and make sure it holds a queue
+ * of the same type. A creator holds its lock from just
+ * after it makes the segment until the queue is ready,
+ * so while the lock is held we wait. A segment we can
+ * lock that is not ready was left by a creator that
+ * died. Only one still empty is unclear, as its creator
+ * may not have locked it yet; it is stale if it stays
+ * that way for SETUP_MICROSECONDS
+ **********************************************/
+template <class T>
+typename ShmQueue <T> ::Found ShmQueue <T> :: attach(const char * name)
+{
+   int fd = shm_open(name, O_RDWR, 0600);
+   if (fd < 0)
+      return MISSING;
+
+   Found found = IN_USE;
+   struct stat status;
+   for (int waited = 0; waited < SETUP_MICROSECONDS; waited += 100)
+   {
+      if (flock(fd, LOCK_SH | LOCK_NB) != 0)
+         found = IN_USE;
+      else if (fstat(fd, &status) != 0)
+         break;
+      else if ((size_t)status.st_size < sizeof(Header))
+      {
+         found = STALE;
+         flock(fd, LOCK_UN);
+      }
+      else
+      {
+         found = ATTACHED;
+         break;
+      }
+      usleep(100);
+   }
+   if (found != ATTACHED)
+   {
+      if (found == STALE && flock(fd, LOCK_EX | LOCK_NB) == 0 &&
+          named(name, fd))
+         shm_unlink(name);
+      close(fd);
+      return found;
+   }
+
+   bytes = status.st_size;
+   void * memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      close(fd);
+      return IN_USE;
+   }
+   header = (Header *)memory;
+
+   // locked and not ready: whoever was making it is gone
+   found = ATTACHED;
+   if (!header->ready.load(std::memory_order_acquire))
+      found = STALE;
+   else if (header->magic != MAGIC ||
+            header->itemSize != sizeof(T) ||
+            bytes < sizeFor(header->capacity))
+      found = IN_USE;
+
+   if (found != ATTACHED)
+   {
+      munmap(memory, bytes);
+      header = NULL;
+      bytes = 0;
+      if (found == STALE && flock(fd, LOCK_EX | LOCK_NB) == 0 &&
+          named(name, fd))
+         shm_unlink(name);
+      close(fd);
+      return found;
+   }
+   this->fd = fd;
+   return ATTACHED;
+}
+
+/**************************************
+ * SHM QUEUE :: PUSH
+ * Write the item, then publish it by moving the tail
+ ***************************************/
+template <class T>
+bool ShmQueue <T> :: push(const T & t)
+{
+   uint64_t tail = header->tail.load(std::memory_order_relaxed);
+   uint64_t head = header->head.load(std::memory_order_acquire);
+   if (tail - head >= header->capacity)
+      return false;
+
+   memcpy((void *)slot(tail), (const void *)&t, sizeof(T));
+   header->tail.store(tail + 1, std::memory_order_release);
+   return true;
+}
+
+/**************************************
+ * SHM QUEUE :: FRONT
+ ***************************************/
+template <class T>
+T ShmQueue <T> :: front() const
+{
+   uint64_t head = header->head.load(std::memory_order_relaxed);
+   if (head == header->tail.load(std::memory_order_acquire))
+      throw "ERROR: attempting to access an item in an empty queue";
+
+   T t;
+   memcpy((void *)&t, (const void *)slot(head), sizeof(T));
+   return t;
+}
+
+/**************************************
+ * SHM QUEUE :: POP
+ * Moving the head hands the slot back to the producer
+ ***************************************/
+template <class T>
+void ShmQueue <T> :: pop()
+{
+   uint64_t head = header->head.load(std::memory_order_relaxed);
+   if (head == header->tail.load(std::memory_order_acquire))
+      throw "ERROR: attempting to pop from an empty queue";
+   header->head.store(head + 1, std::memory_order_release);
+}
+
+/**************************************
+ * SHM QUEUE :: TRY POP
+ * The front and the pop with one look at the tail
+ ***************************************/
+template <class T>
+bool ShmQueue <T> :: tryPop(T & t) noexcept
+{
+   uint64_t head = header->head.load(std::memory_order_relaxed);
+   if (head == header->tail.load(std::memory_order_acquire))
+      return false;
+
+   memcpy((void *)&t, (const void *)slot(head), sizeof(T));
+   header->head.store(head + 1, std::memory_order_release);
+   return true;
+}
+
+#endif // SHM_QUEUE_H
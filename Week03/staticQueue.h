@@ -0,0 +1,148 @@
+/***********************************************************************
+* Header:
+*    STATIC QUEUE
+* Summary:
+*    A Queue whose items live inside the object, for code that may not
+*    touch the heap once it is running. The capacity N is fixed when it
+*    is compiled and must be a power of two, so the head and the tail
+*    are found with a mask rather than a divide.
+*
+*    It has the same members as Queue, so one can be swapped for the
+*    other with a typedef. The differences are the ones a fixed buffer
+*    forces on it:
+*        - push() throws when it is full rather than growing, the way
+*          Queue throws when it cannot grow. tryPush() returns false
+*          instead, for code that expects to fill it
+*        - front(), back(), and pop() on an empty queue are caught by
+*          assert(); tryPop() and tryFront() do not need it
+*    Everything is constexpr, so a StaticQueue can be filled and
+*    emptied while the program is being compiled.
+*
+*    This will contain the class definition of:
+*        StaticQueue      : a Queue of at most N items with no heap
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef STATIC_QUEUE_H
+#define STATIC_QUEUE_H
+
+#include <cassert>       // for ASSERT
+#include <optional>      // for OPTIONAL
+#include <type_traits>   // for IS_NOTHROW_COPY_ASSIGNABLE
+#include <utility>       // for MOVE
+
+/************************************************
+ * STATIC QUEUE
+ * A ring buffer of N items kept in the object
+ ***********************************************/
+template <class T, int N>
+class StaticQueue
+{
+   static_assert(N > 0 && (N & (N - 1)) == 0,
+                 "StaticQueue capacity must be a power of two");
+
+public:
+   // default constructor : empty, with every slot default constructed
+   constexpr StaticQueue() noexcept : data(), countIn(0), countOut(0) {}
+
+   // the compiler's copy, assignment, and destructor are what we want
+
+   // is the container currently empty
+   constexpr bool empty() const noexcept { return size() == 0;        }
+
+   // remove all the items from the container
+   constexpr void clear() noexcept       { countIn = 0; countOut = 0; }
+
+   // how many items are currently in the container?
+   constexpr int size() const noexcept   { return (int)(countIn - countOut); }
+   constexpr int capacity() const noexcept { return N;                }
+
+   // add an item to the back. Throws, and nothing changes, if it is full
+   constexpr void push(const T & t)
+   {
+      if (!tryPush(t))
+         throw "ERROR: Unable to push onto a full StaticQueue";
+   }
+
+   // the same without throwing. False, and nothing changes, if it is
+   // full, so the answer must be looked at
+   [[nodiscard]] constexpr bool tryPush(const T & t)
+      noexcept(std::is_nothrow_copy_assignable <T> ::value)
+   {
+      if (size() == N)
+         return false;
+      data[countIn & MASK] = t;
+      countIn++;
+      return true;
+   }
+
+   // the items at either end. The queue must not be empty
+   constexpr T & front() noexcept
+   {
+      assert(!empty());
+      return data[countOut & MASK];
+   }
+   constexpr const T & front() const noexcept
+   {
+      assert(!empty());
+      return data[countOut & MASK];
+   }
+   constexpr T & back() noexcept
+   {
+      assert(!empty());
+      return data[(countIn - 1) & MASK];
+   }
+   constexpr const T & back() const noexcept
+   {
+      assert(!empty());
+      return data[(countIn - 1) & MASK];
+   }
+
+   // remove the item at either end. The queue must not be empty
+   constexpr void pop() noexcept
+   {
+      assert(!empty());
+      countOut++;
+   }
+   constexpr void popBack() noexcept
+   {
+      assert(!empty());
+      countIn--;
+   }
+
+   // the front item, or an empty optional if there is nothing
+   constexpr std::optional <T> tryFront() const
+      noexcept(std::is_nothrow_copy_constructible <T> ::value)
+   {
+      if (empty())
+         return std::nullopt;
+      return data[countOut & MASK];
+   }
+
+   // move the front item into "t" and remove it. False if it is empty
+   constexpr bool tryPop(T & t)
+      noexcept(std::is_nothrow_move_assignable <T> ::value)
+   {
+      if (empty())
+         return false;
+      t = std::move(data[countOut & MASK]);
+      countOut++;
+      return true;
+   }
+
+   // the raw slots, as Queue::operator[] gives them
+   constexpr T & operator [] (int index) noexcept       { return data[index]; }
+   constexpr const T & operator [] (int index) const noexcept
+      { return data[index]; }
+
+private:
+   enum { MASK = N - 1 };
+
+   T data[N];               // the items, in the object itself
+   unsigned int countIn;    // the number of items added; wraps harmlessly
+   unsigned int countOut;   // the number of items removed
+};
+
+#endif // STATIC_QUEUE_H
@@ -11,26 +11,715 @@
 #include <iostream>    // for ISTREAM, OSTREAM, CIN, and COUT
 #include <string>      // for STRING
 #include <cassert>     // for ASSERT
+#include <cctype>      // for ISSPACE, ISDIGIT, and ISALNUM
+#include <cstring>     // for STRNCMP, STRLEN, and MEMCPY
+#include <climits>     // for INT_MAX
 #include "stock.h"     // for STOCK_TRANSACTION
 #include "queue.h"     // for QUEUE
+#include "reportWriter.h"   // for REPORT_WRITER
+#include "journalCodec.h"   // for JOURNAL_ENCODER and JOURNAL_DECODER
+#include "latency.h"   // for LATENCY_RECORDER
 using namespace std;
 
+/********************************************
+ * SET TICKER
+ * Copy a ticker into a command if it is one: a letter,
+ * then letters, digits, and dots, no longer than a
+ * SymbolTable takes
+ *******************************************/
+static bool setTicker(Command & command, const char * begin,
+                      const char * end)
+{
+   size_t length = end - begin;
+   if (length == 0 || length > SymbolTable::MAX_LENGTH ||
+       !isalpha((unsigned char)*begin))
+      return false;
+   for (const char * p = begin; p != end; p++)
+      if (!isalnum((unsigned char)*p) && *p != '.')
+         return false;
+   memcpy(command.ticker, begin, length);
+   command.ticker[length] = '\0';
+   return true;
+}
+
+/********************************************
+ * COMMAND READ
+ * Read one command from the input stream: the next line
+ * that is not blank, tokenized by parseCommand() so there
+ * is only one grammar. Anything after the command on the
+ * line is ignored, and anything not understood is INVALID
+ *******************************************/
+istream & operator >> (istream & in, Command & rhs)
+{
+   rhs = Command();
+
+   string line;
+   while (getline(in, line))
+      if (line.find_first_not_of(" \t\r\v\f") != string::npos)
+      {
+         rhs = parseCommand(line);
+         break;
+      }
+
+   return in;
+}
+
+/********************************************
+ * SKIP SPACE
+ * Move past white space in a line of text
+ *******************************************/
+static const char * skipSpace(const char * p, const char * end)
+{
+   while (p != end && isspace((unsigned char)*p))
+      p++;
+   return p;
+}
+
+/********************************************
+ * PARSE INTEGER
+ * Read an int the way a stream would: white space, a
+ * sign, then digits. Returns NULL if there are no digits
+ * or the number does not fit in an int
+ *******************************************/
+static const char * parseInteger(const char * p, const char * end,
+                                 int & value)
+{
+   p = skipSpace(p, end);
+   bool negative = false;
+   if (p != end && (*p == '-' || *p == '+'))
+      negative = (*p++ == '-');
+   if (p == end || !isdigit((unsigned char)*p))
+      return NULL;
+
+   long long number = 0;
+   for (; p != end && isdigit((unsigned char)*p); p++)
+   {
+      number = number * 10 + (*p - '0');
+      if (number > (long long)INT_MAX + 1)
+         return NULL;
+   }
+   if (negative)
+      number = -number;
+   if (number > INT_MAX || number < INT_MIN)
+      return NULL;
+   value = (int)number;
+   return p;
+}
+
+/********************************************
+ * PARSE COMMAND
+ * Tokenize one line of text into a command, straight from
+ * the characters rather than through a stream. Every way
+ * of reading commands comes through here:
+ *     buy 200 $1.57      --> BUY 200 at 157 cents
+ *     sell 5 $2.00 ACME  --> SELL 5 of ACME at 200 cents
+ *     display            --> DISPLAY
+ *******************************************/
+Command parseCommand(const char * begin, const char * end)
+{
+   Command command;
+   const char * p = skipSpace(begin, end);
+   const char * word = p;
+   while (p != end && !isspace((unsigned char)*p))
+      p++;
+   int length = (int)(p - word);
+
+   if ((length == 3 && strncmp(word, "buy", 3) == 0) ||
+       (length == 4 && strncmp(word, "sell", 4) == 0))
+   {
+      command.type = (length == 3 ? Command::BUY : Command::SELL);
+      p = parseInteger(p, end, command.shares);
+      if (p == NULL || command.shares <= 0)
+         return Command();
+
+      // no price at all, as opposed to one that reads as $0.00
+      const char * price = p;
+      while (price != end &&
+             (isspace((unsigned char)*price) || *price == '$'))
+         price++;
+      if (price == end)
+         return Command();
+      const char * priced = Dollars::parse(p, end, command.price);
+
+      // and the ticker, if there is one. It is a word of its own, so
+      // "$1.5abc" is a bad price rather than ticker "abc"
+      const char * ticker = p = skipSpace(priced, end);
+      while (p != end && !isspace((unsigned char)*p))
+         p++;
+      if (ticker != p &&
+          (ticker == priced || !setTicker(command, ticker, p)))
+         return Command();
+   }
+   else if (length == 7 && strncmp(word, "display", 7) == 0)
+      command.type = Command::DISPLAY;
+   else if (length == 4 && strncmp(word, "lots", 4) == 0)
+      command.type = Command::LOTS;
+   else if (length == 4 && strncmp(word, "asof", 4) == 0)
+   {
+      command.type = Command::ASOF;
+      p = parseInteger(p, end, command.shares);
+      if (p == NULL || command.shares < 0)
+         return Command();
+   }
+   else if (length == 4 && strncmp(word, "quit", 4) == 0)
+      command.type = Command::QUIT;
+   else if (length == 5 && strncmp(word, "stats", 5) == 0)
+      command.type = Command::STATS;
+
+   return command;
+}
+
+Command parseCommand(const string & line)
+{
+   return parseCommand(line.data(), line.data() + line.size());
+}
+
+// what each type of command is called in a latency report
+static const char * const COMMAND_NAMES[] =
+   { "invalid", "buy", "sell", "display", "lots", "asof", "quit", "stats" };
+
+/*******************************************
+ * TOTAL TEXT
+ * A total as text both a stream and a report writer
+ * can take, in the same form as Dollars
+ ******************************************/
+struct TotalText
+{
+   TotalText(const Total & total)
+   {
+      text[total.format(text)] = '\0';
+   }
+   operator const char * () const { return text; }
+   char text[Total::MAX_TEXT + 1];
+};
+
+/*******************************************
+ * FORMAT EVENT
+ * Format one line of a report:
+ *    Currently held:
+ *            Bought 200 shares at $1.57
+ *    Sell History:
+ *            Sold 150 shares at $2.15 for a profit of $87.00
+ *    Holding 50 shares with a cost basis of $100.00
+ *    Worth $107.50 at $2.15 for an unrealized profit of $7.50
+ *    Proceeds: $87.00
+ *    As of trade 20:
+ *    Latency by command:
+ *            buy: 200 commands, p50 41ns, p99 88ns, p99.9 130ns, max 2100ns
+ ******************************************/
+template <class Out>
+static Out & formatEvent(Out & out, const Event & rhs)
+{
+   switch (rhs.kind)
+   {
+      case Event::HELD_HEADER:
+         out << "Currently held:\n";
+         break;
+      case Event::HELD:
+         out << "\tBought " << rhs.shares << " shares at " << rhs.price
+             << '\n';
+         break;
+      case Event::SOLD_HEADER:
+         out << "Sell History:\n";
+         break;
+      case Event::SOLD:
+         out << "\tSold " << rhs.shares << " shares at " << rhs.price
+             << " for a profit of " << TotalText(rhs.amount) << '\n';
+         break;
+      case Event::POSITION:
+         out << "Holding " << rhs.shares << " shares with a cost basis of "
+             << TotalText(rhs.amount) << '\n';
+         break;
+      case Event::VALUE:
+         out << "Worth " << TotalText(Total(rhs.price) * rhs.shares)
+             << " at " << rhs.price << " for an unrealized profit of "
+             << TotalText(rhs.amount) << '\n';
+         break;
+      case Event::PROCEEDS:
+         out << "Proceeds: " << TotalText(rhs.amount) << '\n';
+         break;
+      case Event::FINAL:
+         out << "Final report:\n";
+         break;
+      case Event::AS_OF:
+         out << "As of trade " << rhs.shares << ":\n";
+         break;
+      case Event::ERROR:
+         out << "Invalid command\n";
+         break;
+      case Event::LATENCY_HEADER:
+         out << "Latency by command:\n";
+         break;
+      case Event::LATENCY:
+         out << '\t' << COMMAND_NAMES[rhs.command] << ": "
+             << (long long)rhs.getLatency()->getCount() << " commands, p50 "
+             << rhs.getLatency()->percentile(0.50) << "ns, p99 "
+             << rhs.getLatency()->percentile(0.99) << "ns, p99.9 "
+             << rhs.getLatency()->percentile(0.999) << "ns, max "
+             << rhs.getLatency()->max() << "ns\n";
+         break;
+      case Event::SNAPSHOT:
+      {
+         Queue <Event> lines;
+         rhs.getSnapshot()->reportLots(lines);
+         Event line;
+         while (lines.tryPop(line))
+            formatEvent(out, line);
+         break;
+      }
+   }
+   return out;
+}
+
+/*******************************************
+ * EVENT DISPLAY
+ * The same line to a stream or to a report writer
+ ******************************************/
+ostream & operator << (ostream & out, const Event & rhs)
+{
+   return formatEvent(out, rhs);
+}
+
+ReportWriter & operator << (ReportWriter & out, const Event & rhs)
+{
+   return formatEvent(out, rhs);
+}
+
+/*******************************************
+ * COMMAND LATENCY
+ * Made the first time it is asked for. Only the
+ * portfolios that are handed it record into it
+ ******************************************/
+LatencyRecorder & commandLatency()
+{
+   static LatencyRecorder recorder(Command::STATS + 1);
+   return recorder;
+}
+
+/*******************************************
+ * REPORT LATENCY
+ * A line for each type of command, skipping any that
+ * have not been seen
+ ******************************************/
+void reportLatency(const LatencyRecorder & latency, Queue <Event> & events)
+{
+   events.push(Event(Event::LATENCY_HEADER));
+   for (int type = Command::INVALID; type <= Command::STATS; type++)
+   {
+      shared_ptr <const LatencyHistogram> histogram =
+         make_shared <const LatencyHistogram> (latency.merged(type));
+      if (histogram->getCount())
+         events.push(Event((Command::Type)type, histogram));
+   }
+}
+
+/********************************************
+ * PORTFOLIO :: BUY
+ * Every buy is a new lot in its symbol's position. Ids
+ * are dense, so the positions grow one symbol at a time
+ *******************************************/
+template <class Strategy>
+void BasicPortfolio <Strategy> :: buy(int shares, const Dollars & price,
+                                      uint32_t symbol)
+{
+   assert(shares > 0);
+   if (symbol >= positions.size())
+      positions.resize(symbol + 1);
+   Position <Strategy> & position = positions[symbol];
+   position.lots.push(Lot(shares, price, nextSeq++));
+
+   Total cost = Total(price) * shares;
+   position.shares += shares;
+   position.costBasis += cost;
+   position.lastPrice = price;
+   this->shares += shares;
+   costBasis += cost;
+   lastPrice = price;
+}
+
+/********************************************
+ * PORTFOLIO :: SELL
+ * Sell in the order the symbol's book keeps its lots,
+ * splitting the last lot if we do not need all of it.
+ * A symbol we never bought has nothing to sell
+ *******************************************/
+template <class Strategy>
+int BasicPortfolio <Strategy> :: sell(int shares, const Dollars & price,
+                                      uint32_t symbol)
+{
+   if (symbol >= positions.size())
+      return 0;
+   Position <Strategy> & position = positions[symbol];
+   int sold = sellLots(position.lots, shares,
+                       [&](const Lot & lot, int take)
+   {
+      Total profit = (Total(price) - Total(lot.price)) * take;
+      Total cost = Total(lot.price) * take;
+      SaleLog <Strategy> ::push(history, Sale(take, price, profit));
+      proceeds += profit;
+      position.costBasis -= cost;
+      costBasis -= cost;
+   });
+
+   // a sell with nothing to sell is not a trade, so it sets no price
+   position.shares -= sold;
+   this->shares -= sold;
+   if (sold > 0)
+   {
+      position.lastPrice = price;
+      lastPrice = price;
+   }
+   return sold;
+}
+
+/********************************************
+ * PORTFOLIO :: GET MARKET VALUE
+ * This walks the symbols, but not their lots
+ *******************************************/
+template <class Strategy>
+Total BasicPortfolio <Strategy> :: getMarketValue() const
+{
+   Total value;
+   for (size_t i = 0; i < positions.size(); i++)
+      value += Total(positions[i].lastPrice) * positions[i].shares;
+   return value;
+}
+
+/********************************************
+ * PORTFOLIO :: GET LOTS VALUE
+ *******************************************/
+template <class Strategy>
+Total BasicPortfolio <Strategy> :: getLotsValue() const
+{
+   long long value = 0;
+   for (size_t i = 0; i < positions.size(); i++)
+      value += positions[i].lots.value();
+   return Total::fromUnits(value);
+}
+
+/********************************************
+ * PORTFOLIO :: APPLY
+ * Carry out one command. Display and quit put the
+ * report on the events
+ *******************************************/
+template <class Strategy>
+void BasicPortfolio <Strategy> :: apply(const Command & command,
+                                        Queue <Event> & events,
+                                        uint32_t symbol)
+{
+   switch (command.type)
+   {
+      case Command::BUY:
+         buy(command.shares, command.price, symbol);
+         break;
+      case Command::SELL:
+         sell(command.shares, command.price, symbol);
+         break;
+      case Command::DISPLAY:
+         report(events);
+         break;
+      case Command::LOTS:
+         reportLots(events);
+         break;
+      case Command::QUIT:
+         events.push(Event(Event::FINAL));
+         report(events);
+         break;
+      case Command::ASOF:        // only a PortfolioHistory can look back
+      case Command::STATS:       //    or report the latency
+      case Command::INVALID:
+         events.push(Event(Event::ERROR));
+         break;
+   }
+}
+
+/********************************************
+ * PORTFOLIO :: REPORT
+ * The position, what it is worth, and the proceeds. When
+ * we hold more than one symbol, each one's worth is at its
+ * own price on a line of its own. This only uses the
+ * running totals so it costs the same no matter how many
+ * lots we hold
+ *******************************************/
+template <class Strategy>
+void BasicPortfolio <Strategy> :: report(Queue <Event> & events) const
+{
+   events.push(Event(Event::POSITION, shares, Dollars(), costBasis));
+
+   int held = 0;
+   Dollars price = lastPrice;
+   for (size_t i = 0; i < positions.size(); i++)
+      if (positions[i].shares > 0)
+      {
+         held++;
+         price = positions[i].lastPrice;
+      }
+
+   if (held <= 1)
+      events.push(Event(Event::VALUE, shares, price, getUnrealized()));
+   else
+      for (size_t i = 0; i < positions.size(); i++)
+         if (positions[i].shares > 0)
+            events.push(Event(Event::VALUE, positions[i].shares,
+                              positions[i].lastPrice,
+                              Total(positions[i].lastPrice) *
+                                 positions[i].shares -
+                                 positions[i].costBasis));
+   events.push(Event(Event::PROCEEDS, 0, Dollars(), proceeds));
+}
+
+/********************************************
+ * PORTFOLIO :: REPORT LOTS
+ * Everything we hold, a symbol at a time, everything we
+ * sold, and the proceeds. The lots are walked on a copy
+ * so nothing is consumed
+ *******************************************/
+template <class Strategy>
+void BasicPortfolio <Strategy> :: reportLots(Queue <Event> & events) const
+{
+   if (shares > 0)
+      events.push(Event(Event::HELD_HEADER));
+   for (size_t i = 0; i < positions.size(); i++)
+      for (LotBook <Strategy> lots(positions[i].lots); !lots.empty();
+           lots.take(lots.next().shares))
+         events.push(Event(Event::HELD, lots.next().shares,
+                           lots.next().price));
+
+   if (!history.empty())
+   {
+      events.push(Event(Event::SOLD_HEADER));
+      for (int i = 0; i < (int)history.size(); i++)
+         events.push(Event(Event::SOLD, history[i].shares,
+                           history[i].price, history[i].profit));
+   }
+
+   events.push(Event(Event::PROCEEDS, 0, Dollars(), proceeds));
+}
+
+// the portfolios the program uses
+template class BasicPortfolio <Fifo>;
+template class BasicPortfolio <SharedFifo>;
+
+// begins with something no ticker can, so it is nobody's name
+const char * const PortfolioHistory::UNNAMED = "-";
+
+/********************************************
+ * PORTFOLIO HISTORY : NON-DEFAULT CONSTRUCTOR
+ * Checkpoint 0 is the empty portfolio, and the first
+ * symbol is the one for trades without a ticker
+ *******************************************/
+PortfolioHistory :: PortfolioHistory(int interval, int maxTrades,
+                                     LatencyRecorder * shared) :
+   interval(interval), maxTrades(maxTrades), trades(0), oldest(0),
+   latency(Command::STATS + 1), shared(shared)
+{
+   assert(interval > 0 && maxTrades >= 0);
+   symbols.intern(UNNAMED, strlen(UNNAMED));
+   if (maxTrades)
+      checkpoints.push_back(portfolio);
+}
+
+/********************************************
+ * PORTFOLIO HISTORY :: APPLY
+ * Trades go in the journal before they are made, and a
+ * checkpoint is taken after every "interval" of them.
+ * Once the journal has an interval more than it has to
+ * keep, the oldest interval goes, with the checkpoint it
+ * started from. The time
+ * taken is recorded before any latency report is made,
+ * so a report includes the command asking for it
+ *******************************************/
+void PortfolioHistory :: apply(const Command & command,
+                               Queue <Event> & events)
+{
+   uint64_t start = LatencyRecorder::now();
+   if (command.type == Command::ASOF)
+   {
+      if (command.shares < oldest || command.shares > trades)
+         events.push(Event(Event::ERROR));
+      else
+      {
+         events.push(Event(Event::AS_OF, command.shares));
+         asOf(command.shares).report(events);
+      }
+   }
+   else if (command.type == Command::LOTS)
+      events.push(Event(portfolio.snapshot()));
+   else if (command.type != Command::STATS)
+   {
+      bool trade = (command.type == Command::BUY ||
+                    command.type == Command::SELL);
+      uint32_t symbol = 0;
+      if (trade && command.ticker[0])
+         symbol = symbols.intern(command.ticker, strlen(command.ticker));
+
+      portfolio.apply(command, events, symbol);
+      if (trade)
+      {
+         trades++;
+         if (maxTrades == 0)
+            oldest = trades;
+         else
+         {
+            journal.push_back(TradeRecord(symbol, command.shares,
+                                          command.price,
+                                          command.type == Command::BUY ?
+                                          TradeRecord::BUY :
+                                          TradeRecord::SELL));
+            if (trades % interval == 0)
+               checkpoints.push_back(portfolio);
+            if ((int)journal.size() >= maxTrades + interval)
+            {
+               journal.erase(journal.begin(), journal.begin() + interval);
+               checkpoints.pop_front();
+               oldest += interval;
+            }
+         }
+      }
+   }
+   uint64_t ticks = LatencyRecorder::now() - start;
+   latency.record(command.type, ticks);
+   if (shared)
+      shared->record(command.type, ticks);
+
+   if (command.type == Command::STATS || command.type == Command::QUIT)
+      reportLatency(latency, events);
+}
+
+/********************************************
+ * PORTFOLIO HISTORY :: GET RECORD
+ * Trade "trade" is the one that made it trade number
+ * "trade", so the first kept is getOldest() + 1
+ *******************************************/
+const TradeRecord & PortfolioHistory :: getRecord(int trade) const
+{
+   if (trade <= oldest || trade > trades)
+      throw "ERROR: no such trade";
+   return journal[trade - oldest - 1];
+}
+
+/********************************************
+ * PORTFOLIO HISTORY :: AS OF
+ * Start from the last checkpoint at or before the trade
+ * and replay the journal from there
+ *******************************************/
+SnapshotPortfolio PortfolioHistory :: asOf(int trade) const
+{
+   if (trade < oldest || trade > trades)
+      throw "ERROR: no such trade";
+   if (trade == trades)
+      return portfolio;
+
+   int nearest = (trade - oldest) / interval;
+   assert(nearest < (int)checkpoints.size());
+   SnapshotPortfolio past(checkpoints[nearest]);
+   for (int i = nearest * interval; i < trade - oldest; i++)
+      if (journal[i].isBuy())
+         past.buy(journal[i].shares, journal[i].price, journal[i].symbol);
+      else
+         past.sell(journal[i].shares, journal[i].price, journal[i].symbol);
+   return past;
+}
+
+/********************************************
+ * PORTFOLIO HISTORY :: EXPORT JOURNAL
+ * One row per trade: its command type, shares, price,
+ * and number. Without the tickers, trades in different
+ * symbols would be matched against each other when the
+ * journal is read back, so only unnamed trades go out
+ *******************************************/
+string PortfolioHistory :: exportJournal() const
+{
+   if (oldest > 0)
+      throw "ERROR: the first trades are no longer kept";
+
+   JournalEncoder encoder;
+   for (int i = 0; i < trades; i++)
+   {
+      if (journal[i].symbol != 0)
+         throw "ERROR: the journal encoding has no tickers";
+      encoder.add(JournalRow(journal[i].isBuy() ? Command::BUY :
+                                                  Command::SELL,
+                             journal[i].shares,
+                             journal[i].price.getCents(), i));
+   }
+   return encoder.finish();
+}
+
+/********************************************
+ * PORTFOLIO HISTORY :: IMPORT JOURNAL
+ * Every row has to be a trade. They are made in the
+ * order they were journaled, after any already made
+ *******************************************/
+void PortfolioHistory :: importJournal(const string & encoding)
+{
+   JournalDecoder decoder(encoding.data(), encoding.size());
+   JournalRow rows[1024];
+   Queue <Event> unused;
+   int count;
+   while ((count = decoder.next(rows, 1024)) > 0)
+      for (int i = 0; i < count; i++)
+      {
+         if ((rows[i].kind != Command::BUY &&
+              rows[i].kind != Command::SELL) || rows[i].shares <= 0)
+            throw "ERROR: the journal has something in it that is not a trade";
+         Command command;
+         command.type = (Command::Type)rows[i].kind;
+         command.shares = rows[i].shares;
+         command.price = Dollars(rows[i].cents);
+         apply(command, unused);
+         unused.clear();
+      }
+}
+
 /************************************************
  * STOCKS BUY SELL
  * The interactive function allowing the user to
- * buy and sell stocks
+ * buy and sell stocks. The output of each command and
+ * the next prompt go out in one write, just before we
+ * wait for the user again
  ***********************************************/
 void stocksBuySell()
 {
-   // instructions
-   cout << "This program will allow you to buy and sell stocks. "
-        << "The actions are:\n";
-   cout << "  buy 200 $1.57   - Buy 200 shares at $1.57\n";
-   cout << "  sell 150 $2.15  - Sell 150 shares at $2.15\n";
-   cout << "  display         - Display your current stock portfolio\n";
-   cout << "  quit            - Display a final report and quit the program\n";
-
-   // your code here...
+   // the menu went through cout, so it has to get out first
+   cout.flush();
+   ReportWriter out;
+   stocksBuySell(cin, out);
 }
 
+/************************************************
+ * STOCKS BUY SELL
+ * The prompts and the report on any stream and writer
+ ***********************************************/
+void stocksBuySell(istream & in, ReportWriter & out)
+{
+   // instructions
+   out << "This program will allow you to buy and sell stocks. "
+       << "The actions are:\n";
+   out << "  buy 200 $1.57   - Buy 200 shares at $1.57\n";
+   out << "  sell 150 $2.15  - Sell 150 shares at $2.15\n";
+   out << "                    (either may end with a ticker, such as ACME)\n";
+   out << "  display         - Display your current stock portfolio\n";
+   out << "  lots            - Display every lot held and every sale\n";
+   out << "  asof 20         - Display the portfolio after the 20th trade\n";
+   out << "  stats           - Display how long each command has taken\n";
+   out << "  quit            - Display a final report and quit the program\n";
+
+   PortfolioHistory portfolio;
+   Queue <Event> events;
+   Command command;
+   do
+   {
+      out << "> ";
+      out.flush();
+      if (!(in >> command))
+         command.type = Command::QUIT;
 
+      portfolio.apply(command, events);
+      Event event;
+      while (events.tryPop(event))
+         out << event;
+   }
+   while (command.type != Command::QUIT);
+   out.flush();
+}
@@ -12,11 +12,347 @@
 #define STOCK_H
 
 #include "dollars.h"   // for Dollars defined in StockTransaction
+#include "fixedPoint.h"     // for FIXED_POINT
 #include "queue.h"     // for QUEUE
+#include "lotBook.h"   // for LOT and LOT_BOOK
+#include "reportWriter.h"   // for REPORT_WRITER
+#include "cowQueue.h"  // for COW_QUEUE
+#include "symbolTable.h"    // for TRADE_RECORD
+#include "latency.h"   // for LATENCY_RECORDER
 #include <iostream>    // for ISTREAM and OSTREAM
+#include <string>      // for STRING
+#include <memory>      // for SHARED_PTR
+#include <vector>      // for VECTOR
+#include <deque>       // for DEQUE
+
+/******************************************
+ * TOTAL
+ * Money added up over many trades. Whole cents, as
+ * Dollars, but in 64 bits: a running total in int
+ * cents overflows at about $21 million
+ ******************************************/
+typedef FixedPoint <2> Total;
+
+/******************************************
+ * SALE
+ * Part of a lot that was sold, remembered for the sell history
+ ******************************************/
+struct Sale
+{
+   Sale() : shares(0), price(), profit() {}
+   Sale(int shares, const Dollars & price, const Total & profit) :
+      shares(shares), price(price), profit(profit) {}
+
+   int     shares;     // how many shares were sold
+   Dollars price;      // what each share was sold for
+   Total   profit;     // sale price less what we paid for them
+};
+
+/******************************************
+ * COMMAND
+ * One tokenized line of input to the stock program:
+ *    buy 200 $1.57
+ *    sell 150 $2.15 ACME
+ *    display
+ *    lots
+ *    asof 20
+ *    stats
+ *    quit
+ * A buy or a sell may end with the ticker it trades:
+ * letters, digits, and dots. A sell only sells what was
+ * bought with the same ticker, or with none if it has
+ * none. The text is kept in the command so it stays
+ * trivially copyable
+ ******************************************/
+struct Command
+{
+   enum Type { INVALID, BUY, SELL, DISPLAY, LOTS, ASOF, QUIT, STATS };
+
+   Command() : type(INVALID), shares(0), price() { ticker[0] = '\0'; }
+
+   Type    type;
+   int     shares;     // for BUY and SELL, or the trade for ASOF
+   Dollars price;      // only used for BUY and SELL
+   char    ticker[SymbolTable::MAX_LENGTH + 1];   // or "" if none was given
+};
+
+// read the next line that is not blank as one command
+std::istream & operator >> (std::istream & in, Command & rhs);
+
+// tokenize a single line of text into a command
+Command parseCommand(const std::string & line);
+Command parseCommand(const char * begin, const char * end);
+
+template <class Strategy>
+class BasicPortfolio;
+typedef BasicPortfolio <SharedFifo> SnapshotPortfolio;
+
+/******************************************
+ * EVENT
+ * The output of the portfolio: one line of a report. The
+ * portfolio produces these so that formatting the text can
+ * happen somewhere other than where the lots are matched.
+ * A SNAPSHOT is the whole lots report as of one moment,
+ * left for whoever formats it to walk. A LATENCY is how
+ * long the "command" type of command has been taking.
+ * Either one keeps what it needs in "detail", which the
+ * other kinds leave empty, so an event carries one
+ * pointer at most
+ ******************************************/
+struct Event
+{
+   enum Kind { HELD_HEADER, HELD, SOLD_HEADER, SOLD, POSITION, VALUE,
+               PROCEEDS, FINAL, AS_OF, ERROR, SNAPSHOT, LATENCY_HEADER,
+               LATENCY };
+
+   Event() : kind(ERROR), command(Command::INVALID), shares(0), price(),
+             amount() {}
+   Event(Kind kind, int shares = 0,
+         const Dollars & price = Dollars(),
+         const Total & amount = Total()) :
+      kind(kind), command(Command::INVALID), shares(shares), price(price),
+      amount(amount) {}
+   Event(const std::shared_ptr <const SnapshotPortfolio> & snapshot) :
+      kind(SNAPSHOT), command(Command::INVALID), shares(0), price(),
+      amount(), detail(snapshot) {}
+   Event(Command::Type command,
+         const std::shared_ptr <const LatencyHistogram> & latency) :
+      kind(LATENCY), command(command), shares(0), price(), amount(),
+      detail(latency) {}
+
+   // what the detail points to, or NULL for any other kind of event
+   const SnapshotPortfolio * getSnapshot() const
+   {
+      return kind == SNAPSHOT ?
+         static_cast <const SnapshotPortfolio *> (detail.get()) : NULL;
+   }
+   const LatencyHistogram * getLatency() const
+   {
+      return kind == LATENCY ?
+         static_cast <const LatencyHistogram *> (detail.get()) : NULL;
+   }
+
+   Kind    kind;
+   Command::Type command;   // only for LATENCY: what was timed
+   int     shares;
+   Dollars price;
+   Total   amount;     // the cost basis for POSITION, else the profit
+   std::shared_ptr <const void> detail;   // only for SNAPSHOT and LATENCY
+};
+
+// format one line of a report
+std::ostream & operator << (std::ostream & out, const Event & rhs);
+ReportWriter & operator << (ReportWriter & out, const Event & rhs);
+
+// a recorder for every type of command, on every thread, since the
+// program started. A PortfolioHistory given it times into it as well
+// as into its own
+LatencyRecorder & commandLatency();
+
+// the latency of every type of command a recorder has seen
+void reportLatency(const LatencyRecorder & latency, Queue <Event> & events);
+
+/******************************************
+ * SALE LOG
+ * Where a portfolio keeps what it sold: a vector, or for
+ * a book whose copies share their lots, a copy-on-write
+ * queue so the sales are shared too
+ ******************************************/
+template <class Strategy>
+struct SaleLog
+{
+   typedef std::vector <Sale> Type;
+   static void push(Type & sales, const Sale & sale) { sales.push_back(sale); }
+};
+
+template <>
+struct SaleLog <SharedFifo>
+{
+   typedef CowQueue <Sale> Type;
+   static void push(Type & sales, const Sale & sale) { sales.push(sale); }
+};
+
+/******************************************
+ * POSITION
+ * What we hold of one symbol: its lots, and running
+ * totals of them so a report never walks the lots
+ ******************************************/
+template <class Strategy>
+struct Position
+{
+   Position() : shares(0), costBasis(), lastPrice() {}
+
+   LotBook <Strategy> lots;   // what we own of it, in the order it sells
+   int     shares;            // the sum of the shares in the lots
+   Total   costBasis;         // what we paid for the lots
+   Dollars lastPrice;         // the price of its most recent trade
+};
+
+/******************************************
+ * BASIC PORTFOLIO
+ * The shares we currently hold and the history of what
+ * we sold. Each symbol has a position of its own, indexed
+ * by its id from a SymbolTable, and a sale only draws on
+ * the lots of its symbol. Trades without one are symbol 0.
+ * The totals are kept up to date with every trade so the
+ * summary never needs to walk the lots. The Strategy is
+ * the LotBook the lots are kept in:
+ *    Portfolio         : a LotQueue, the fastest to trade
+ *    SnapshotPortfolio : copy-on-write queues, so copying it
+ *                        is O(1) a symbol and the copy can be
+ *                        read on another thread while this
+ *                        one trades
+ ******************************************/
+template <class Strategy>
+class BasicPortfolio
+{
+public:
+   BasicPortfolio() : shares(0), costBasis(), lastPrice(), proceeds(),
+                      nextSeq(0) {}
+
+   // buy some shares of a symbol at a given price
+   void buy(int shares, const Dollars & price, uint32_t symbol = 0);
+
+   // sell shares of a symbol, in the order its lots sell. Returns
+   // the number sold
+   int sell(int shares, const Dollars & price, uint32_t symbol = 0);
+
+   // apply one command, adding any output to the events. The ticker
+   // is the caller's to turn into a symbol id
+   void apply(const Command & command, Queue <Event> & events,
+              uint32_t symbol = 0);
+
+   // the totals: position, value, and proceeds
+   void report(Queue <Event> & events) const;
+
+   // every lot we hold and every sale we made
+   void reportLots(Queue <Event> & events) const;
+
+   // a copy as of now that another thread can report from. It only
+   // costs O(1) a symbol for a SnapshotPortfolio
+   std::shared_ptr <const BasicPortfolio> snapshot() const
+   {
+      return std::make_shared <const BasicPortfolio> (*this);
+   }
+
+   // the running totals
+   int     getShares()      const { return shares;                  }
+   Total   getCostBasis()   const { return costBasis;               }
+   Dollars getLastPrice()   const { return lastPrice;               }
+   Total   getUnrealized()  const { return getMarketValue() - costBasis; }
+   Total   getProceeds()    const { return proceeds;                }
+
+   // what we hold of one symbol
+   int getShares(uint32_t symbol) const
+   {
+      return symbol < positions.size() ? positions[symbol].shares : 0;
+   }
+
+   // every symbol's shares at its own last price
+   Total getMarketValue() const;
+
+   // what the lots cost, walking every one of them. It should always
+   // be the running cost basis; this is for checking that
+   Total getLotsValue() const;
+
+private:
+   std::vector <Position <Strategy> > positions;   // by symbol id
+   typename SaleLog <Strategy> ::Type history;   // what we sold, in order
+   int            shares;     // the sum of the shares in the positions
+   Total          costBasis;  // what we paid for the positions
+   Dollars        lastPrice;  // the price of the most recent trade
+   Total          proceeds;   // the sum of all the profits
+   int            nextSeq;    // the sequence id of the next buy
+};
+
+typedef BasicPortfolio <Fifo> Portfolio;
+
+/******************************************
+ * PORTFOLIO HISTORY
+ * A portfolio that can say what it looked like after
+ * any trade it has made. Every buy and sell is kept in a
+ * journal, and every "interval" trades the portfolio is
+ * copied as a checkpoint. It is a SnapshotPortfolio, whose
+ * copies share their lots, so a checkpoint only costs the
+ * segments that changed since the one before. Checkpoint
+ * k is the state after trade k * interval, so finding the
+ * nearest one is a division and a query replays fewer
+ * than "interval" trades.
+ * Only the last "maxTrades" trades are kept, and fewer
+ * than an interval more, so a program that trades forever
+ * does not grow forever. Older ones are let go an interval
+ * at a time, along with their checkpoint. With a maxTrades
+ * of 0 nothing is kept and only now can be asked about.
+ * The journal holds TradeRecords. A trade's ticker is
+ * interned into the history's SymbolTable, and that id is
+ * the position it trades and what the record carries;
+ * a trade that names none has id 0, UNNAMED. Every command
+ * is timed into a recorder of the history's own, which
+ * is what STATS reports, and into a shared one if given
+ ******************************************/
+class PortfolioHistory
+{
+public:
+   // how many trades are kept unless we are told otherwise
+   static const int KEEP_TRADES = 1 << 20;
+
+   // what a trade without a ticker is recorded as. It is not a ticker
+   // anyone can type, so it always has id 0
+   static const char * const UNNAMED;
+
+   PortfolioHistory(int interval = 1024, int maxTrades = KEEP_TRADES,
+                    LatencyRecorder * shared = NULL);
+
+   // apply one command, journaling the trades and answering ASOF and
+   // STATS. LOTS is answered with a snapshot for whoever formats the
+   // events to walk. QUIT reports the latency after the final report
+   void apply(const Command & command, Queue <Event> & events);
+
+   // the portfolio as it was after the first "trade" trades. Trades
+   // from getOldest() to getTrades() can be asked about
+   SnapshotPortfolio asOf(int trade) const;
+
+   // how many trades have been made, and the first one still kept
+   int getTrades() const          { return trades;              }
+   int getOldest() const          { return oldest;              }
+
+   // the portfolio as it is now
+   const SnapshotPortfolio & current() const { return portfolio; }
+
+   // how long each type of command took here
+   const LatencyRecorder & getLatency() const { return latency;  }
+
+   // every ticker the journal has seen, and the record of the trade
+   // that made it "trade" trades. getOldest() + 1 is the first kept
+   const SymbolTable & getSymbols() const     { return symbols;  }
+   const TradeRecord & getRecord(int trade) const;
+
+   // every trade so far in the compact journal encoding, and making
+   // the trades in such a journal as if they had been typed in. There
+   // is nothing to export once the first trades have been let go. The
+   // encoding has no tickers, so a journal that names any is not
+   // exported either
+   std::string exportJournal() const;
+   void importJournal(const std::string & encoding);
+
+private:
+   SnapshotPortfolio portfolio;         // after every trade
+   SymbolTable symbols;                 // the tickers in the journal
+   std::deque <TradeRecord> journal;    // the buys and sells kept, in order
+   std::deque <SnapshotPortfolio> checkpoints;   // every "interval" trades
+   int interval;                        // trades between checkpoints
+   int maxTrades;                       // most trades in the journal
+   int trades;                          // how many trades have been made
+   int oldest;                          // the trade the journal starts at
+   LatencyRecorder latency;             // this history's commands
+   LatencyRecorder * shared;            // everyone's, or NULL
+};
 
 // the interactive stock buy/sell function
 void stocksBuySell();
 
+// the same reading commands from "in" and writing the report to "out"
+void stocksBuySell(std::istream & in, ReportWriter & out);
+
 #endif // STOCK_H
 
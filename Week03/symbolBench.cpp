@@ -0,0 +1,110 @@
+/***********************************************************************
+ * Program:
+ *    SYMBOL BENCH
+ * Summary:
+ *    A stream of trades in a few thousand tickers, carried two ways:
+ *    with the ticker as a std::string in every trade, and interned to
+ *    an id in a 16 byte TradeRecord. Each way pushes the whole stream
+ *    onto a Queue that starts empty, so it grows as it goes, then pops
+ *    it off adding up the shares traded in each symbol.
+ *
+ *        symbolBench [trades] [symbols]
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#include <iostream>          // for COUT
+#include <random>            // for MT19937
+#include <chrono>            // for STEADY_CLOCK
+#include <cstdlib>           // for ATOL
+#include <string>            // for STRING
+#include <unordered_map>     // for UNORDERED_MAP
+#include <vector>            // for VECTOR
+#include "queue.h"           // for QUEUE
+#include "symbolTable.h"     // for SYMBOL_TABLE and TRADE_RECORD
+using namespace std;
+
+/*******************************************
+ * TICKER TRADE
+ * A trade that carries its ticker, as a stream of
+ * text would hand it to us
+ *******************************************/
+struct TickerTrade
+{
+   string   ticker;
+   int      shares;
+   Dollars  price;
+   uint32_t flags;
+};
+
+/*******************************************
+ * SECONDS SINCE
+ *******************************************/
+double secondsSince(const chrono::steady_clock::time_point & start)
+{
+   return chrono::duration <double> (chrono::steady_clock::now() - start)
+      .count();
+}
+
+/**********************************************************************
+ * MAIN
+ * The same stream both ways, and the same totals from each
+ ***********************************************************************/
+int main(int argc, char ** argv)
+{
+   long count = (argc > 1 ? atol(argv[1]) : 5000000);
+   int symbols = (argc > 2 ? atoi(argv[2]) : 5000);
+
+   // tickers of 1 to 5 letters, some far more traded than others
+   mt19937 random(1);
+   vector <string> tickers;
+   for (int i = 0; i < symbols; i++)
+   {
+      string ticker;
+      for (int length = 1 + (int)(random() % 5); length > 0; length--)
+         ticker += (char)('A' + random() % 26);
+      tickers.push_back(ticker + to_string(i));
+   }
+   vector <int> stream(count);
+   for (long i = 0; i < count; i++)
+      stream[i] = (int)((random() % symbols) * (random() % symbols) /
+                        symbols);
+
+   // the ticker in every trade
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   Queue <TickerTrade> text;
+   for (long i = 0; i < count; i++)
+      text.push(TickerTrade { tickers[stream[i]], (int)(i % 100) + 1,
+                              Dollars((int)i), TradeRecord::BUY });
+   unordered_map <string, long long> textTotals;
+   TickerTrade trade;
+   while (text.tryPop(trade))
+      textTotals[trade.ticker] += trade.shares;
+   double textSeconds = secondsSince(start);
+
+   // the ticker interned as it comes in
+   start = chrono::steady_clock::now();
+   SymbolTable table;
+   Queue <TradeRecord> records;
+   for (long i = 0; i < count; i++)
+      records.push(TradeRecord(table.intern(tickers[stream[i]]),
+                               (int)(i % 100) + 1, Dollars((int)i),
+                               TradeRecord::BUY));
+   vector <long long> idTotals(table.size());
+   TradeRecord record;
+   while (records.tryPop(record))
+      idTotals[record.symbol] += record.shares;
+   double idSeconds = secondsSince(start);
+
+   bool same = (textTotals.size() == table.size());
+   for (uint32_t id = 0; same && id < table.size(); id++)
+      same = (textTotals[table.name(id)] == idTotals[id]);
+
+   cout << count << " trades in " << table.size() << " symbols\n";
+   cout << "string\t" << textSeconds * 1e9 / count << " ns/trade\t"
+        << sizeof(TickerTrade) << " bytes/trade\n";
+   cout << "interned\t" << idSeconds * 1e9 / count << " ns/trade\t"
+        << sizeof(TradeRecord) << " bytes/trade\n";
+   cout << "totals " << (same ? "match\n" : "DIFFER\n");
+   return same ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/***********************************************************************
+ * Implementation:
+ *    SYMBOL TABLE
+ * Summary:
+ *    Linear probing over dense ids
+ * Author
+ *    <your names here>
+ **********************************************************************/
+
+#include <cstring>           // for MEMCMP
+#include "symbolTable.h"     // for SYMBOL_TABLE
+using namespace std;
+
+/********************************************
+ * SYMBOL TABLE :: PROBE
+ * The number of slots is a power of two, so the mask
+ * wraps the search around the end. The table is never
+ * more than half full, so there is always an empty slot
+ * to stop at. The hash is compared first so that most
+ * other tickers are passed over without looking at them
+ *******************************************/
+size_t SymbolTable :: probe(const char * text, size_t length,
+                            uint32_t hash) const
+{
+   size_t mask = slots.size() - 1;
+   size_t slot = hash & mask;
+   for (;;)
+   {
+      uint32_t id = slots[slot];
+      if (id == NOT_FOUND ||
+          (hashes[id] == hash && names[id].size() == length &&
+           memcmp(names[id].data(), text, length) == 0))
+         return slot;
+      slot = (slot + 1) & mask;
+   }
+}
+
+/********************************************
+ * SYMBOL TABLE :: FIND
+ *******************************************/
+uint32_t SymbolTable :: find(const char * text, size_t length) const
+{
+   return slots[probe(text, length, hash(text, length))];
+}
+
+/********************************************
+ * SYMBOL TABLE :: INTERN
+ * A new ticker gets the next id. The slots are
+ * doubled before they get more than half full.
+ * Everything that can throw is done before the
+ * table changes, so a failure leaves it as it was
+ *******************************************/
+uint32_t SymbolTable :: intern(const char * text, size_t length)
+{
+   if (length == 0 || length > MAX_LENGTH)
+      throw "ERROR: a ticker must be 1 to 15 characters";
+
+   uint32_t code = hash(text, length);
+   size_t slot = probe(text, length, code);
+   if (slots[slot] != NOT_FOUND)
+      return slots[slot];
+
+   // room for one more in both, doubling so a run of new tickers
+   // costs the same as push_back() would
+   string name(text, length);
+   size_t room = names.size() * 2 + 8;
+   if (names.capacity() == names.size())
+      names.reserve(room);
+   if (hashes.capacity() == hashes.size())
+      hashes.reserve(room);
+   if ((names.size() + 1) * 2 > slots.size())
+   {
+      grow();
+      slot = probe(text, length, code);
+   }
+
+   uint32_t id = size();
+   names.push_back(string());
+   names.back().swap(name);
+   hashes.push_back(code);
+   slots[slot] = id;
+   return id;
+}
+
+/********************************************
+ * SYMBOL TABLE :: NAME
+ *******************************************/
+const string & SymbolTable :: name(uint32_t id) const
+{
+   if (id >= size())
+      throw "ERROR: no symbol has that id";
+   return names[id];
+}
+
+/********************************************
+ * SYMBOL TABLE :: GROW
+ * Every id goes in the first empty slot after its
+ * hash. They are all different, so nothing is compared
+ *******************************************/
+void SymbolTable :: grow()
+{
+   vector <uint32_t> bigger(slots.size() * 2, NOT_FOUND);
+   size_t mask = bigger.size() - 1;
+   for (uint32_t id = 0; id < size(); id++)
+   {
+      size_t slot = hashes[id] & mask;
+      while (bigger[slot] != NOT_FOUND)
+         slot = (slot + 1) & mask;
+      bigger[slot] = id;
+   }
+   slots.swap(bigger);
+}
@@ -0,0 +1,124 @@
+/***********************************************************************
+ * Header:
+ *    SYMBOL TABLE
+ * Summary:
+ *    Tickers as small numbers. A SymbolTable hands out ids 0, 1, 2, ...
+ *    in the order it first sees each ticker, so a trade can carry its
+ *    symbol in four bytes and anything kept per symbol can be a plain
+ *    array indexed by id. The text is only looked at once, when the
+ *    ticker comes in; after that it is compared and copied as a number.
+ *
+ *    The table is open addressing with linear probing over the ids,
+ *    kept at most half full. Tickers are short, so each name is a
+ *    std::string that fits in its small string buffer and costs no
+ *    allocation of its own.
+ *
+ *    A TradeRecord is one trade as the engine keeps it: sixteen bytes,
+ *    aligned so four fill a cache line exactly and none straddles two.
+ *    It is trivially copyable, so a Queue of them moves with memcpy
+ *    where a Queue of tickers would copy every string.
+ *
+ *    This will contain the class definitions of:
+ *        TradeRecord      : a symbol id, shares, a price, and flags
+ *        SymbolTable      : tickers to dense ids and back
+ * Author
+ *    <your names here>
+ ************************************************************************/
+
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <cstddef>       // for SIZE_T
+#include <cstdint>       // for UINT32_T
+#include <string>        // for STRING
+#include <type_traits>   // for IS_TRIVIALLY_COPYABLE
+#include <vector>        // for VECTOR
+#include "dollars.h"     // for DOLLARS
+
+/******************************************
+ * TRADE RECORD
+ * One trade of one symbol. The flags say which side
+ * it was on, with room for more
+ ******************************************/
+struct alignas(16) TradeRecord
+{
+   enum Flags { BUY = 1, SELL = 2 };
+
+   TradeRecord() : symbol(0), shares(0), price(), flags(0) {}
+   TradeRecord(uint32_t symbol, int shares, const Dollars & price,
+               uint32_t flags) :
+      symbol(symbol), shares(shares), price(price), flags(flags) {}
+
+   bool isBuy() const  { return (flags & BUY) != 0;  }
+   bool isSell() const { return (flags & SELL) != 0; }
+
+   uint32_t symbol;    // an id from a SymbolTable
+   int      shares;
+   Dollars  price;     // what each share traded for
+   uint32_t flags;     // BUY or SELL
+};
+
+static_assert(sizeof(TradeRecord) == 16, "a TradeRecord is 16 bytes");
+static_assert(std::is_trivially_copyable <TradeRecord> ::value,
+              "a TradeRecord is copied as raw bytes");
+
+/******************************************
+ * SYMBOL TABLE
+ * Gives each ticker the next id the first time it is
+ * seen, and the same id every time after that
+ ******************************************/
+class SymbolTable
+{
+public:
+   // no id is ever this
+   static constexpr uint32_t NOT_FOUND = 0xffffffff;
+
+   // the longest ticker we take
+   static constexpr size_t MAX_LENGTH = 15;
+
+   // default constructor : no symbols yet
+   SymbolTable() : slots(16, NOT_FOUND) {}
+
+   // the id of a ticker, giving it a new one if it has none yet.
+   // Throws if the ticker is empty or too long
+   uint32_t intern(const char * text, size_t length);
+   uint32_t intern(const std::string & ticker)
+   {
+      return intern(ticker.data(), ticker.size());
+   }
+
+   // the id of a ticker, or NOT_FOUND if it has none
+   uint32_t find(const char * text, size_t length) const;
+   uint32_t find(const std::string & ticker) const
+   {
+      return find(ticker.data(), ticker.size());
+   }
+
+   // the ticker with an id
+   const std::string & name(uint32_t id) const;
+
+   // how many symbols there are, which is one more than the last id
+   uint32_t size() const           { return (uint32_t)names.size();  }
+
+private:
+   // FNV-1a; tickers are too short to need anything better
+   static uint32_t hash(const char * text, size_t length)
+   {
+      uint32_t value = 2166136261u;
+      for (size_t i = 0; i < length; i++)
+         value = (value ^ (unsigned char)text[i]) * 16777619u;
+      return value;
+   }
+
+   // the slot holding a ticker's id, or the empty slot it would go in
+   size_t probe(const char * text, size_t length, uint32_t hash) const;
+
+   // twice the slots, with every id placed again
+   void grow();
+
+   std::vector <uint32_t> slots;       // ids, or NOT_FOUND if empty
+   std::vector <std::string> names;    // indexed by id
+   std::vector <uint32_t> hashes;      // indexed by id, for grow()
+};
+
+#endif // SYMBOL_TABLE_H
@@ -14,6 +14,8 @@
 #include <string>      //
 #include "queue.h"     // your Queue class should be in queue.h
 #include "stock.h"     // your stocksBuySell() function
+#include "pipeline.h"  // for stocksPipeline()
+#include "server.h"    // for StockServer
 #include "dollars.h"   // for the Dollars class
 using namespace std;
 
@@ -39,6 +41,11 @@ void testErrors();
  ***********************************************************************/
 int main()
 {
+   // cin with a buffer of its own can tell the pipeline whether more
+   // input is ready; synced with stdio it never can. This has to come
+   // before anything is read
+   ios_base::sync_with_stdio(false);
+
    // menu
    cout << "Select the test you want to run:\n";
    cout << "\t1. Just create and destroy a Queue\n";
@@ -46,6 +53,8 @@ int main()
    cout << "\t3. The above plus test implementation of the circular Queue\n";
    cout << "\t4. Exercise the error handling\n";
    cout << "\ta. Selling Stock\n";
+   cout << "\tb. Selling Stock, one thread per stage\n";
+   cout << "\tc. Selling Stock, served on a socket path or a port\n";
 
    // select
    char choice;
@@ -56,6 +65,35 @@ int main()
       case 'a':
          stocksBuySell();
          break;
+      case 'b':
+      {
+         // the menu went through cout, so it has to get out first
+         cout.flush();
+         PipelineStats stats;
+         {
+            ReportWriter out;
+            stocksPipeline(cin, out, stats);
+         }
+         cout << stats;
+         break;
+      }
+      case 'c':
+      {
+         string address;
+         cout << "Address: ";
+         cin  >> address;
+         try
+         {
+            StockServer server(address.c_str());
+            cout << "Serving on " << address << endl;
+            server.run();
+         }
+         catch (const char * error)
+         {
+            cout << error << endl;
+         }
+         break;
+      }
       case '1':
          testSimple();
          cout << "Test 1 complete\n";
@@ -0,0 +1,251 @@
+/***********************************************************************
+* Header:
+*    WORK DEQUE
+* Summary:
+*    The Chase-Lev work-stealing deque: the ring buffer of Queue, with
+*    countIn and countOut made atomic, for handing out work to threads.
+*    One thread owns the deque and pushes and pops at the tail, where
+*    the work is freshest. Any number of other threads steal from the
+*    head, where the oldest work is.
+*
+*    The owner and the thieves only contend for the last item. The owner
+*    grows the buffer by copying the items into one twice as big and
+*    publishing it; a thief still reading the old buffer finds the same
+*    items there, so nobody waits. Old buffers are kept until the deque
+*    is destroyed, which costs at most as much again as the biggest one.
+*
+*    Items are copied by threads that race with each other, so only
+*    trivially copyable types such as pointers and indexes can be used.
+*
+*    This will contain the class definition of:
+*        WorkDeque        : a work-stealing deque of T
+*
+* Author
+*    <your names here>
+************************************************************************/
+
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+#include <atomic>        // for ATOMIC
+#include <cstdint>       // for INT64_T
+#include <type_traits>   // for IS_TRIVIALLY_COPYABLE
+#include <vector>        // for VECTOR
+#include <new>           // for BAD_ALLOC
+
+/************************************************
+ * WORK DEQUE
+ * Pushed and popped at the tail by its owner, and
+ * stolen from at the head by everyone else
+ ***********************************************/
+template <class T>
+class WorkDeque
+{
+   static_assert(std::is_trivially_copyable <T> ::value,
+                 "WorkDeque items are copied while they are being raced for");
+
+public:
+   // non-default constructor : room for "capacity" items, rounded up
+   // to a power of two
+   WorkDeque(int capacity = 64);
+
+   // destructor : the current buffer and every one it replaced
+   ~WorkDeque();
+
+   // roughly how many items there are. Exact only for the owner when
+   // nobody is stealing
+   int size() const noexcept
+   {
+      int64_t count = countIn.load(std::memory_order_relaxed) -
+                      countOut.load(std::memory_order_relaxed);
+      return count > 0 ? (int)count : 0;
+   }
+   bool empty() const noexcept { return size() == 0;               }
+   int capacity() const noexcept
+   {
+      return (int)buffer.load(std::memory_order_relaxed)->capacity;
+   }
+
+   // owner: add an item at the tail, growing if it is full
+   void push(const T & t);
+
+   // owner: take the newest item. False if there is none
+   bool popBack(T & t) noexcept;
+
+   // thief: take the oldest item. False if there is none, or another
+   // thread got it first
+   bool steal(T & t) noexcept;
+
+private:
+   /******************************************
+    * BUFFER
+    * A power of two slots. Count "i" is in slot i & mask,
+    * exactly as Queue::locHead() finds it
+    ******************************************/
+   struct Buffer
+   {
+      Buffer(int64_t capacity) : capacity(capacity),
+         items(new std::atomic <T> [capacity]) {}
+      ~Buffer()                       { delete [] items;             }
+
+      T get(int64_t count) const noexcept
+      {
+         return items[count & (capacity - 1)]
+            .load(std::memory_order_relaxed);
+      }
+      void put(int64_t count, const T & t) noexcept
+      {
+         items[count & (capacity - 1)].store(t, std::memory_order_relaxed);
+      }
+
+      int64_t capacity;
+      std::atomic <T> * items;
+   };
+
+   // no copying a deque other threads are stealing from
+   WorkDeque(const WorkDeque & rhs);
+   WorkDeque & operator = (const WorkDeque & rhs);
+
+   // owner: move the items into a buffer twice as big
+   Buffer * grow(Buffer * old, int64_t in, int64_t out);
+
+   alignas(64) std::atomic <int64_t> countOut;   // items ever stolen
+   alignas(64) std::atomic <int64_t> countIn;    // the owner's tail
+   std::atomic <Buffer *> buffer;                // the current buffer
+   std::vector <Buffer *> retired;               // ones it replaced
+};
+
+/**********************************************
+ * WORK DEQUE : NON-DEFAULT CONSTRUCTOR
+ **********************************************/
+template <class T>
+WorkDeque <T> :: WorkDeque(int capacity) : countOut(0), countIn(0)
+{
+   int64_t rounded = 1;
+   while (rounded < capacity)
+      rounded *= 2;
+   buffer.store(new Buffer(rounded), std::memory_order_relaxed);
+}
+
+/**********************************************
+ * WORK DEQUE : DESTRUCTOR
+ * No thief may still be using the deque
+ **********************************************/
+template <class T>
+WorkDeque <T> :: ~WorkDeque()
+{
+   delete buffer.load(std::memory_order_relaxed);
+   for (size_t i = 0; i < retired.size(); i++)
+      delete retired[i];
+}
+
+/**********************************************
+ * WORK DEQUE :: GROW
+ * Copy the live counts to the same counts in the new
+ * buffer, so the head and the tail do not move
+ **********************************************/
+template <class T>
+typename WorkDeque <T> ::Buffer * WorkDeque <T> :: grow(Buffer * old,
+                                                         int64_t in,
+                                                         int64_t out)
+{
+   // make room to retire the old buffer first, so nothing can throw
+   // once the new one is ours to free
+   Buffer * bigger;
+   try
+   {
+      retired.reserve(retired.size() + 1);
+      bigger = new Buffer(old->capacity * 2);
+   }
+   catch (std::bad_alloc)
+   {
+      throw "ERROR: Unable to grow the work deque";
+   }
+
+   for (int64_t count = out; count < in; count++)
+      bigger->put(count, old->get(count));
+   retired.push_back(old);
+   buffer.store(bigger, std::memory_order_release);
+   return bigger;
+}
+
+/**************************************
+ * WORK DEQUE :: PUSH
+ * Write the item, then publish it by moving the tail
+ ***************************************/
+template <class T>
+void WorkDeque <T> :: push(const T & t)
+{
+   int64_t in  = countIn.load(std::memory_order_relaxed);
+   int64_t out = countOut.load(std::memory_order_acquire);
+   Buffer * current = buffer.load(std::memory_order_relaxed);
+   if (in - out >= current->capacity)
+      current = grow(current, in, out);
+
+   current->put(in, t);
+   std::atomic_thread_fence(std::memory_order_release);
+   countIn.store(in + 1, std::memory_order_relaxed);
+}
+
+/**************************************
+ * WORK DEQUE :: POP BACK
+ * Claim the tail first, then see whether a thief has
+ * reached it. Only the last item needs the CAS
+ ***************************************/
+template <class T>
+bool WorkDeque <T> :: popBack(T & t) noexcept
+{
+   int64_t in = countIn.load(std::memory_order_relaxed) - 1;
+   Buffer * current = buffer.load(std::memory_order_relaxed);
+   countIn.store(in, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   int64_t out = countOut.load(std::memory_order_relaxed);
+
+   if (out > in)
+   {
+      // it was already empty
+      countIn.store(in + 1, std::memory_order_relaxed);
+      return false;
+   }
+
+   T item = current->get(in);
+   if (out == in)
+   {
+      // the last item: whoever moves countOut past it gets it
+      bool won = countOut.compare_exchange_strong(out, out + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed);
+      countIn.store(in + 1, std::memory_order_relaxed);
+      if (!won)
+         return false;
+   }
+   t = item;
+   return true;
+}
+
+/**************************************
+ * WORK DEQUE :: STEAL
+ * Read the head item, then claim it by moving countOut.
+ * If the claim fails someone else took it and the copy
+ * we read is thrown away
+ ***************************************/
+template <class T>
+bool WorkDeque <T> :: steal(T & t) noexcept
+{
+   int64_t out = countOut.load(std::memory_order_acquire);
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   int64_t in = countIn.load(std::memory_order_acquire);
+   if (out >= in)
+      return false;
+
+   Buffer * current = buffer.load(std::memory_order_acquire);
+   T item = current->get(out);
+   if (!countOut.compare_exchange_strong(out, out + 1,
+                                         std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+      return false;
+   t = item;
+   return true;
+}
+
+#endif // WORK_DEQUE_H